@@ -119,11 +119,474 @@ namespace phylo
       }
    };
 
+   static bool starts_with(const string_view &text, const char *prefix, string_view &rest)
+   {
+      const usize length = strlen(prefix);
+      if ((text.size() < length) || (memcmp(text.data(), prefix, length) != 0))
+      {
+         return false;
+      }
+      rest = text.substr(length);
+      return true;
+   }
+
+   // Reads a plain decimal number between min and max inclusive. Returns false otherwise, including on overflow.
+   static bool parse_number(const string_view &text, uint64 min, uint64 max, uint64 &value)
+   {
+      if (text.empty())
+      {
+         return false;
+      }
+      value = 0;
+      for (char c : text)
+      {
+         if ((c < '0') | (c > '9'))
+         {
+            return false;
+         }
+         const uint64 digit = uint64(c - '0');
+         if ((digit > max) || (value > ((max - digit) / 10)))
+         {
+            return false;
+         }
+         value = (value * 10) + digit;
+      }
+      return value >= min;
+   }
+
+   // Reads where the workers go, which has to happen before anything starts the scheduler:
+   //   --workers=N     how many, counting the simulation thread (default: one per processor it may use)
+   //   --no-smt        at most one per physical core
+   //   --pin=POLICY    compact (default), scatter, none, or a list of processors such as 0-15,64-79
+   //   --numa          split the fused tick's tiles and the cell store by NUMA node (needs pinning)
+   static bool configure_scheduler(const array_view<string_view> &arguments)
+   {
+      Scheduler::Configuration configuration;
+      for (const string_view &argument : arguments)
+      {
+         string_view value;
+         if (starts_with(argument, "--workers=", value))
+         {
+            uint64 count;
+            if (!parse_number(value, 1, Topology::MaxProcessors, count))
+            {
+               xdebug("PHYLO", "--workers expects a number from 1 to %u", Topology::MaxProcessors);
+               return false;
+            }
+            configuration.Workers = usize(count);
+         }
+         else if (argument == "--no-smt")
+         {
+            configuration.SMT = false;
+         }
+         else if (argument == "--numa")
+         {
+            configuration.Numa = true;
+         }
+         else if (starts_with(argument, "--pin=", value))
+         {
+            if (value == "compact")
+            {
+               configuration.Pinning = Topology::Pinning::Compact;
+            }
+            else if (value == "scatter")
+            {
+               configuration.Pinning = Topology::Pinning::Scatter;
+            }
+            else if (value == "none")
+            {
+               configuration.Pinning = Topology::Pinning::None;
+            }
+            else if (Topology::parse_list(value, configuration.Processors))
+            {
+               configuration.Pinning = Topology::Pinning::List;
+            }
+            else
+            {
+               xdebug("PHYLO", "--pin expects compact, scatter, none or a list of processors");
+               return false;
+            }
+         }
+      }
+
+      Scheduler::configure(configuration);
+      return true;
+   }
+
+   // Logs a benchmark's report and writes it out. Returns false if the file could not be written.
+   static bool write_report(const char *path, const string &report)
+   {
+      xdebug("PHYLO", "%s", report);
+      try
+      {
+         io::file outFile(path, io::file::Flags::New | io::file::Flags::Sequential | io::file::Flags::Write, report.size());
+         outFile.write(0, report.data(), report.size());
+      }
+      catch (...)
+      {
+         return false;
+      }
+      return true;
+   }
+
+   // Measures the fixed cost of dispatching a simulation phase to the workers, writes it out and exits without
+   // opening a window.
+   static int benchmark_dispatch()
+   {
+      Scheduler::get().pin_caller();
+      static constexpr uint Phases = 100'000;
+      static constexpr const char *ReportPath = "dispatch_benchmark.txt";
+
+      const Scheduler::DispatchTiming timing = Scheduler::get().measure_dispatch(Phases);
+      const string report = string::format(
+         "workers %u\nphases %u\nmin %.2f us\nmedian %.2f us\np99 %.2f us\nmax %.2f us\n",
+         uint(Scheduler::get().worker_count()), Phases, timing.Min, timing.Median, timing.P99, timing.Max
+      );
+
+      return write_report(ReportPath, report) ? 0 : 1;
+   }
+
+   static string escape_json(const string_view &text)
+   {
+      string out;
+      for (char c : text)
+      {
+         if ((c == '\\') | (c == '"'))
+         {
+            out.push_back('\\');
+         }
+         out.push_back(c);
+      }
+      return out;
+   }
+
+   static double milliseconds_per_tick(clock::time_span span, uint64 ticks)
+   {
+      return (double(int64(span)) / 1'000'000.0) / double(ticks);
+   }
+
+   // The timed parts of a tick, as the headless benchmarks report them.
+   static constexpr std::pair<const char *, clock::time_span Simulation::RunTotals::*> RunPhases[] = {
+      { "vm", &Simulation::RunTotals::VM },
+      { "physics", &Simulation::RunTotals::Physics },
+      { "cells", &Simulation::RunTotals::CellUpdate },
+      { "render_copy", &Simulation::RunTotals::RenderCopy },
+      { "post", &Simulation::RunTotals::Post },
+      { "light", &Simulation::RunTotals::Light },
+      { "serial", &Simulation::RunTotals::Serial },
+      { "parallel", &Simulation::RunTotals::Parallel },
+   };
+
+   // Reads the run length the headless benchmarks share:
+   //   --ticks=N                  ticks timed per run (default 1000)
+   //   --warmup=N                 ticks run first, untimed, so the tuners and caches settle (default 100)
+   static bool read_run_length(const array_view<string_view> &arguments, uint64 &ticks, uint64 &warmupTicks)
+   {
+      static constexpr uint64 MaxTicks = 1'000'000'000;
+      ticks = 1000;
+      warmupTicks = 100;
+      for (const string_view &argument : arguments)
+      {
+         string_view value;
+         if (starts_with(argument, "--ticks=", value) && !parse_number(value, 1, MaxTicks, ticks))
+         {
+            xdebug("PHYLO", "--ticks expects a number from 1 to %llu", MaxTicks);
+            return false;
+         }
+         if (starts_with(argument, "--warmup=", value) && !parse_number(value, 0, MaxTicks, warmupTicks))
+         {
+            xdebug("PHYLO", "--warmup expects a number from 0 to %llu", MaxTicks);
+            return false;
+         }
+      }
+      return true;
+   }
+
+   // Loads the checkpoint afresh, so that every run's tuners and population start from the same place, and runs it
+   // headless for the given number of ticks. configure is called once the checkpoint's options have been applied.
+   template <typename F>
+   static bool run_checkpoint(const string_view &checkpoint, uint64 warmupTicks, uint64 ticks, const F &configure, Simulation::RunTotals &totals)
+   {
+      event startProcessing;
+      event threadStarted;
+      Simulation *simulation;
+      try
+      {
+         simulation = Simulation::load(string(checkpoint), startProcessing, threadStarted);
+      }
+      catch (...)
+      {
+         xdebug("PHYLO", "Could not load %s", string(checkpoint));
+         return false;
+      }
+      configure();
+      simulation->set_tick_limit(warmupTicks, ticks);
+      startProcessing.set();
+      threadStarted.join();
+      simulation->kickoff();
+      totals = simulation->wait_for_run();
+      simulation->halt();
+      delete simulation;
+      return true;
+   }
+
+   // Runs a saved simulation headless for the same number of ticks at 1, 2, 4, ... workers, up to however many
+   // there are, and writes out how each phase scaled as JSON:
+   //   --benchmark-scaling=PATH   the saved simulation to start every run from
+   //   --ticks=N, --warmup=N      as for read_run_length
+   static int benchmark_scaling(const string_view &checkpoint, const array_view<string_view> &arguments)
+   {
+      static constexpr const char *ReportPath = "scaling_benchmark.json";
+      uint64 ticks;
+      uint64 warmupTicks;
+      if (!read_run_length(arguments, ticks, warmupTicks))
+      {
+         return 1;
+      }
+
+      const usize workerCount = Scheduler::get().worker_count();
+      array<usize> threadCounts;
+      for (usize threads = 1; threads < workerCount; threads *= 2)
+      {
+         threadCounts.push_back(threads);
+      }
+      threadCounts.push_back(workerCount);
+
+      string report = string::format(
+         "{\n  \"checkpoint\": \"%s\",\n  \"warmup_ticks\": %llu,\n  \"ticks\": %llu,\n  \"workers\": %u,\n  \"runs\": [\n",
+         escape_json(checkpoint), warmupTicks, ticks, uint(workerCount)
+      );
+      Simulation::RunTotals baseline;
+      for (usize run = 0; run < threadCounts.size(); ++run)
+      {
+         const usize threads = threadCounts[run];
+         Scheduler::get().set_active_workers(threads);
+
+         Simulation::RunTotals totals;
+         if (!run_checkpoint(checkpoint, warmupTicks, ticks, [] {}, totals))
+         {
+            return 1;
+         }
+
+         if (run == 0)
+         {
+            baseline = totals;
+         }
+         const double tickMilliseconds = milliseconds_per_tick(totals.Total, totals.Ticks);
+         const double speedup = milliseconds_per_tick(baseline.Total, baseline.Ticks) / tickMilliseconds;
+         const double serialFraction = double(int64(totals.Serial)) / max(double(int64(totals.Serial + totals.Parallel)), 1.0);
+         // Karp-Flatt: the serial fraction the measured speedup implies, which also takes in overheads the timed
+         // split between serial and parallel work does not see.
+         const string karpFlatt = (threads > 1) ?
+            string::format("%.4f", ((1.0 / speedup) - (1.0 / double(threads))) / (1.0 - (1.0 / double(threads)))) :
+            string("null");
+
+         report += string::format(
+            "    {\n      \"threads\": %u,\n      \"ticks_per_second\": %.2f,\n      \"mean_cells\": %llu,\n      \"speedup\": %.3f,\n      \"efficiency\": %.3f,\n      \"serial_fraction\": %.4f,\n      \"karp_flatt\": %s,\n      \"phases\": {\n",
+            uint(threads), 1000.0 / tickMilliseconds, totals.CellTicks / totals.Ticks, speedup, speedup / double(threads), serialFraction, karpFlatt
+         );
+         for (usize phase = 0; phase < std::size(RunPhases); ++phase)
+         {
+            const auto [name, member] = RunPhases[phase];
+            const double phaseMilliseconds = milliseconds_per_tick(totals.*member, totals.Ticks);
+            const double baselineMilliseconds = milliseconds_per_tick(baseline.*member, baseline.Ticks);
+            // Phases the tick did not run (lights when they are static, or the separate phases of a fused tick)
+            // have no speedup to speak of.
+            const string phaseSpeedup = (phaseMilliseconds > 0.0) ? string::format("%.3f", baselineMilliseconds / phaseMilliseconds) : string("null");
+            report += string::format(
+               "        \"%s\": { \"ms_per_tick\": %.4f, \"speedup\": %s }%s\n",
+               name, phaseMilliseconds, phaseSpeedup, (phase + 1 < std::size(RunPhases)) ? "," : ""
+            );
+         }
+         const auto tuning = [](const Renderer::UIData::PhaseTuning &phase) {
+            return string::format("{ \"grain\": %u, \"workers\": %u }", phase.Grain, phase.Workers);
+         };
+         report += string::format(
+            "      },\n      \"tuning\": {\n        \"vm\": %s,\n        \"integrate\": %s,\n        \"collide\": %s,\n        \"cells\": %s\n      }\n    }%s\n",
+            tuning(totals.VMTuning), tuning(totals.IntegrateTuning), tuning(totals.CollideTuning), tuning(totals.CellTuning), (run + 1 < threadCounts.size()) ? "," : ""
+         );
+      }
+      report += "  ]\n}\n";
+      Scheduler::get().set_active_workers(workerCount);
+
+      return write_report(ReportPath, report) ? 0 : 1;
+   }
+
+   // Runs a saved simulation headless once through each way of executing the VM phase, with every worker, and writes
+   // out how each compared with interpreting every cell on its own as JSON:
+   //   --benchmark-executors=PATH the saved simulation to start every run from
+   //   --ticks=N, --warmup=N      as for read_run_length
+   // The batched executors run one instruction per cell and are not profiled, so whatever the checkpoint's options,
+   // the runs are made at one instruction per tick without profiling, and phase by phase so that the VM phase is timed
+   // on its own.
+   static int benchmark_executors(const string_view &checkpoint, const array_view<string_view> &arguments)
+   {
+      static constexpr const char *ReportPath = "executor_benchmark.json";
+      uint64 ticks;
+      uint64 warmupTicks;
+      if (!read_run_length(arguments, ticks, warmupTicks))
+      {
+         return 1;
+      }
+
+      const std::pair<const char *, options::VMExecution> executors[] = {
+         { "per_cell", options::VMExecution::PerCell },
+         { "lockstep", options::VMExecution::Lockstep },
+         { "bucketed", options::VMExecution::Bucketed },
+      };
+      string report = string::format(
+         "{\n  \"checkpoint\": \"%s\",\n  \"warmup_ticks\": %llu,\n  \"ticks\": %llu,\n  \"workers\": %u,\n  \"runs\": [\n",
+         escape_json(checkpoint), warmupTicks, ticks, uint(Scheduler::get().worker_count())
+      );
+      Simulation::RunTotals baseline;
+      for (usize run = 0; run < std::size(executors); ++run)
+      {
+         const auto [name, mode] = executors[run];
+         const auto configure = [mode = mode] {
+            options::ExecutionMode = mode;
+            options::InstructionsPerTick = 1;
+            options::FusedTick = false;
+            options::VMProfiling = false;
+         };
+
+         Simulation::RunTotals totals;
+         if (!run_checkpoint(checkpoint, warmupTicks, ticks, configure, totals))
+         {
+            return 1;
+         }
+
+         if (run == 0)
+         {
+            baseline = totals;
+         }
+         const double vmMilliseconds = milliseconds_per_tick(totals.VM, totals.Ticks);
+         const double baselineMilliseconds = milliseconds_per_tick(baseline.VM, baseline.Ticks);
+         // The VM phase scales with the population, which drifts apart between runs, so it is compared per cell.
+         const double vmNanosecondsPerCell = (double(int64(totals.VM)) / double(max(totals.CellTicks, 1ull)));
+         const double baselineNanosecondsPerCell = (double(int64(baseline.VM)) / double(max(baseline.CellTicks, 1ull)));
+         report += string::format(
+            "    {\n      \"executor\": \"%s\",\n      \"ticks_per_second\": %.2f,\n      \"mean_cells\": %llu,\n      \"vm_ms_per_tick\": %.4f,\n      \"vm_ns_per_cell\": %.2f,\n      \"vm_speedup\": %.3f,\n      \"vm_speedup_per_cell\": %.3f\n    }%s\n",
+            name, 1000.0 / milliseconds_per_tick(totals.Total, totals.Ticks), totals.CellTicks / totals.Ticks,
+            vmMilliseconds, vmNanosecondsPerCell, baselineMilliseconds / vmMilliseconds, baselineNanosecondsPerCell / vmNanosecondsPerCell,
+            (run + 1 < std::size(executors)) ? "," : ""
+         );
+      }
+      report += "  ]\n}\n";
+
+      return write_report(ReportPath, report) ? 0 : 1;
+   }
+
+   // Runs a saved simulation headless with every worker, once with each worker's state on cache lines of its own, as
+   // it ships, and once with it packed the way plain arrays would leave it, and writes out what each phase took both
+   // ways as JSON. Each VM executor is run, as each has state of its own, and the per-cell interpreter is run again
+   // profiled, for the profiler's:
+   //   --benchmark-false-sharing=PATH the saved simulation to start every run from
+   //   --ticks=N, --warmup=N          as for read_run_length
+   // Contention for lines shows up here as time; a hardware profiler (such as perf c2c or VTune's memory access
+   // analysis) pointed at the same two runs shows the cache-to-cache transfers behind it.
+   static int benchmark_false_sharing(const string_view &checkpoint, const array_view<string_view> &arguments)
+   {
+      static constexpr const char *ReportPath = "false_sharing_benchmark.json";
+      uint64 ticks;
+      uint64 warmupTicks;
+      if (!read_run_length(arguments, ticks, warmupTicks))
+      {
+         return 1;
+      }
+
+      struct Configuration final
+      {
+         const char           *Name;
+         options::VMExecution Executor;
+         bool                 Profiled;
+      };
+      static constexpr Configuration configurations[] = {
+         { "per_cell", options::VMExecution::PerCell, false },
+         { "per_cell_profiled", options::VMExecution::PerCell, true },
+         { "lockstep", options::VMExecution::Lockstep, false },
+         { "bucketed", options::VMExecution::Bucketed, false },
+      };
+
+      string report = string::format(
+         "{\n  \"checkpoint\": \"%s\",\n  \"warmup_ticks\": %llu,\n  \"ticks\": %llu,\n  \"workers\": %u,\n  \"runs\": [\n",
+         escape_json(checkpoint), warmupTicks, ticks, uint(Scheduler::get().worker_count())
+      );
+      for (usize run = 0; run < std::size(configurations); ++run)
+      {
+         const Configuration &configuration = configurations[run];
+         const auto configure = [&configuration] {
+            options::ExecutionMode = configuration.Executor;
+            options::VMProfiling = configuration.Profiled;
+            options::InstructionsPerTick = 1;
+            options::FusedTick = false;
+         };
+
+         // The layout is picked up as the simulation sizes its per-worker state, while it loads.
+         Simulation::RunTotals layouts[2];
+         for (uint packed = 0; packed < 2; ++packed)
+         {
+            WorkerLocalLayout::Packed = (packed != 0);
+            const bool ran = run_checkpoint(checkpoint, warmupTicks, ticks, configure, layouts[packed]);
+            WorkerLocalLayout::Packed = false;
+            if (!ran)
+            {
+               return 1;
+            }
+         }
+
+         report += string::format("    {\n      \"configuration\": \"%s\",\n      \"phases\": {\n", configuration.Name);
+         for (usize phase = 0; phase < std::size(RunPhases); ++phase)
+         {
+            const auto [name, member] = RunPhases[phase];
+            const double padded = milliseconds_per_tick(layouts[0].*member, layouts[0].Ticks);
+            const double packed = milliseconds_per_tick(layouts[1].*member, layouts[1].Ticks);
+            const string ratio = (padded > 0.0) ? string::format("%.3f", packed / padded) : string("null");
+            report += string::format(
+               "        \"%s\": { \"padded_ms_per_tick\": %.4f, \"packed_ms_per_tick\": %.4f, \"packed_over_padded\": %s }%s\n",
+               name, padded, packed, ratio, (phase + 1 < std::size(RunPhases)) ? "," : ""
+            );
+         }
+         report += string::format(
+            "      },\n      \"padded_mean_cells\": %llu,\n      \"packed_mean_cells\": %llu\n    }%s\n",
+            layouts[0].CellTicks / layouts[0].Ticks, layouts[1].CellTicks / layouts[1].Ticks, (run + 1 < std::size(configurations)) ? "," : ""
+         );
+      }
+      report += "  ]\n}\n";
+
+      return write_report(ReportPath, report) ? 0 : 1;
+   }
+
    static int exec (const array_view<string_view> &arguments)
    {
       GetCurrentDirectoryW(MAX_PATH, WorkingDIr);
       ResetWorkingDirectory();
 
+      if (!configure_scheduler(arguments))
+      {
+         return 1;
+      }
+
+      for (const string_view &argument : arguments)
+      {
+         string_view value;
+         if (argument == "--benchmark-dispatch")
+         {
+            return benchmark_dispatch();
+         }
+         if (starts_with(argument, "--benchmark-scaling=", value))
+         {
+            return benchmark_scaling(value, arguments);
+         }
+         if (starts_with(argument, "--benchmark-executors=", value))
+         {
+            return benchmark_executors(value, arguments);
+         }
+         if (starts_with(argument, "--benchmark-false-sharing=", value))
+         {
+            return benchmark_false_sharing(value, arguments);
+         }
+      }
+
       xdebug("PHYLO", "Starting Phylogen");
 
       // The game consists of two discrete systems:
@@ -0,0 +1,83 @@
+#include "phylogen.hpp"
+#include "Parking.hpp"
+
+#include <chrono>
+#include <Windows.h>
+
+using namespace phylo;
+
+namespace
+{
+   // Backoff between polls tops out here; at that point the spin checks the clock after every round.
+   static constexpr uint MaxPauses = 64;
+}
+
+void ParkingWord::wake()
+{
+   // Pairs with the fence in wait(): either the waiter sees the new value, or we see it parked.
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   if (m_Parked.load(std::memory_order_relaxed) != 0) [[unlikely]]
+   {
+      WakeByAddressAll((void *)&m_Value);
+   }
+}
+
+uint32 ParkingWord::wait(uint32 value)
+{
+   using spin_clock = std::chrono::steady_clock;
+   const spin_clock::time_point deadline = spin_clock::now() + std::chrono::nanoseconds(SpinTimeNanoseconds);
+
+   uint pauses = 1;
+   for (;;)
+   {
+      const uint32 current = m_Value.load(std::memory_order_acquire);
+      if (current != value)
+      {
+         return current;
+      }
+
+      for (uint i = 0; i < pauses; ++i)
+      {
+         YieldProcessor();
+      }
+      if (pauses < MaxPauses)
+      {
+         pauses *= 2;
+      }
+      else if (spin_clock::now() >= deadline)
+      {
+         break;
+      }
+   }
+
+   m_Parked.fetch_add(1, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   uint32 current;
+   // WaitOnAddress rechecks the value once it is queued, so a wake between the load and the wait is not lost.
+   while ((current = m_Value.load(std::memory_order_acquire)) == value)
+   {
+      WaitOnAddress((volatile void *)&m_Value, &value, sizeof(value), INFINITE);
+   }
+   m_Parked.fetch_sub(1, std::memory_order_relaxed);
+   return current;
+}
+
+void ParkingWord::store(uint32 value)
+{
+   m_Value.store(value, std::memory_order_release);
+   wake();
+}
+
+uint32 ParkingWord::fetch_add(uint32 value)
+{
+   const uint32 result = m_Value.fetch_add(value, std::memory_order_acq_rel);
+   wake();
+   return result;
+}
+
+uint32 ParkingWord::fetch_sub(uint32 value)
+{
+   const uint32 result = m_Value.fetch_sub(value, std::memory_order_acq_rel);
+   wake();
+   return result;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <xtd/xtd>
+#include <atomic>
+
+namespace phylo
+{
+   // A word threads can wait on to change. A waiter first spins, backing off exponentially between polls, for up to
+   // SpinTime; only then does it park in the kernel (WaitOnAddress). Writers only make a system call when somebody is
+   // actually parked, so a handoff between threads that are both busy costs a few cache misses rather than two kernel
+   // round trips.
+   class ParkingWord final
+   {
+      std::atomic<uint32> m_Value;
+      std::atomic<uint32> m_Parked = 0;
+
+      void wake();
+
+   public:
+      // Long enough to cover the gap between two phases of a tick, short enough that an idle simulation sleeps.
+      static constexpr uint64 SpinTimeNanoseconds = 50'000;
+
+      explicit ParkingWord(uint32 value = 0) : m_Value(value) {}
+      ParkingWord(const ParkingWord &) = delete;
+      ParkingWord &operator=(const ParkingWord &) = delete;
+
+      uint32 load() const
+      {
+         return m_Value.load(std::memory_order_acquire);
+      }
+
+      // Returns once the word no longer holds 'value', with what it holds now.
+      uint32 wait(uint32 value);
+
+      // These wake every waiter.
+      void store(uint32 value);
+      uint32 fetch_add(uint32 value);
+      uint32 fetch_sub(uint32 value);
+   };
+}
@@ -0,0 +1,143 @@
+#include "phylogen.hpp"
+#include "PhaseTuner.hpp"
+
+using namespace phylo;
+
+PhaseTuner::PhaseTuner(const char *name, usize grain, usize minGrain, usize maxGrain) :
+   m_Name(name),
+   m_MinGrain(minGrain),
+   m_MaxGrain(maxGrain),
+   m_Best{ grain, Scheduler::get().active_worker_count() },
+   m_Trial(m_Best)
+{
+   begin_round();
+}
+
+usize PhaseTuner::grain(const Parameters &parameters, usize count) const
+{
+   // With every worker taking part, the grain is left alone so that idle workers can still steal.
+   if (parameters.Workers >= Scheduler::get().active_worker_count())
+   {
+      return parameters.Grain;
+   }
+   return max(parameters.Grain, (count + parameters.Workers - 1) / parameters.Workers);
+}
+
+bool PhaseTuner::neighbour(uint index, Parameters &parameters) const
+{
+   parameters = m_Best;
+   switch (index)
+   {
+   case 0:
+      parameters.Grain = min(m_Best.Grain * 2, m_MaxGrain); break;
+   case 1:
+      parameters.Grain = max(m_Best.Grain / 2, m_MinGrain); break;
+   case 2:
+      parameters.Workers = min(m_Best.Workers * 2, Scheduler::get().active_worker_count()); break;
+   case 3:
+      parameters.Workers = max((m_Best.Workers + 1) / 2, usize(1)); break;
+   default:
+      __assume(0);
+   }
+   return (parameters.Grain != m_Best.Grain) | (parameters.Workers != m_Best.Workers);
+}
+
+void PhaseTuner::begin_round()
+{
+   m_Settled = false;
+   m_Improved = false;
+   m_Neighbour = 0;
+   begin_trial();
+}
+
+void PhaseTuner::begin_trial()
+{
+   m_Calls = 0;
+   m_BestNanoseconds = 0;
+   m_TrialNanoseconds = 0;
+   m_BestElements = 0;
+   m_TrialElements = 0;
+   while ((m_Neighbour < NeighbourCount) && !neighbour(m_Neighbour, m_Trial))
+   {
+      ++m_Neighbour;
+   }
+}
+
+void PhaseTuner::settle(usize count)
+{
+   m_Settled = true;
+   m_SettledCalls = 0;
+   m_SettledCount = count;
+   if ((m_Best.Grain == m_SettledAt.Grain) & (m_Best.Workers == m_SettledAt.Workers))
+   {
+      return;
+   }
+   m_SettledAt = m_Best;
+   xdebug("PHYLO", "%s tuned to a grain of %llu over %llu workers at %llu elements", m_Name, uint64(m_Best.Grain), uint64(m_Best.Workers), uint64(count));
+}
+
+bool PhaseTuner::measuring(usize count)
+{
+   const Scheduler &scheduler = Scheduler::get();
+   if (scheduler.is_serial() | (scheduler.active_worker_count() == 1) | (count < (m_MinGrain * scheduler.active_worker_count() * MinRangesPerWorker)))
+   {
+      return false;
+   }
+
+   if (m_Settled)
+   {
+      ++m_SettledCalls;
+      if ((m_SettledCalls < SettledCalls) & (count <= (m_SettledCount * 2)) & ((count * 2) >= m_SettledCount))
+      {
+         return false;
+      }
+      begin_round();
+   }
+
+   if (m_Neighbour == NeighbourCount)
+   {
+      // Every neighbour was tried; go around again from wherever this round moved to, or stop.
+      if (m_Improved)
+      {
+         begin_round();
+      }
+      if (m_Neighbour == NeighbourCount)
+      {
+         settle(count);
+         return false;
+      }
+   }
+   return true;
+}
+
+void PhaseTuner::record(usize count, int64 nanoseconds)
+{
+   if (m_Calls & 1)
+   {
+      m_TrialNanoseconds += nanoseconds;
+      m_TrialElements += count;
+   }
+   else
+   {
+      m_BestNanoseconds += nanoseconds;
+      m_BestElements += count;
+   }
+   if (++m_Calls < (SampleCalls * 2))
+   {
+      return;
+   }
+
+   const double bestCost = double(m_BestNanoseconds) / double(m_BestElements);
+   const double trialCost = double(m_TrialNanoseconds) / double(m_TrialElements);
+   if (trialCost < (bestCost * (1.0 - MinImprovement)))
+   {
+      // Keep going the same way from the new choice.
+      m_Best = m_Trial;
+      m_Improved = true;
+   }
+   else
+   {
+      ++m_Neighbour;
+   }
+   begin_trial();
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <xtd/xtd>
+
+#include "Scheduler.hpp"
+
+namespace phylo
+{
+   // Picks the grain of one parallel phase, and how many workers take part in it, while the simulation runs; the best
+   // of both moves a long way with the population and between machines.
+   //
+   // The tuner alternates between its current choice and a neighbouring one (twice or half the grain, or twice or half
+   // the workers) for a few calls, and moves to the neighbour if it costs clearly less per element. Once no neighbour
+   // does, it settles, and starts again every so often or when the population has doubled or halved.
+   //
+   // Workers are limited through the grain: a phase cut into n ranges keeps at most about n workers busy. Every worker
+   // still wakes for the tick, as the scheduler wakes them for the whole graph.
+   class PhaseTuner final
+   {
+   public:
+      struct Parameters final
+      {
+         usize Grain;
+         usize Workers;
+      };
+
+   private:
+      static constexpr uint   SampleCalls = 8;      // Calls measured for each side of a trial.
+      static constexpr uint   NeighbourCount = 4;
+      static constexpr uint   SettledCalls = 1024;  // Calls a settled tuner waits before trying its neighbours again.
+      static constexpr double MinImprovement = 0.03;
+      // Phases with fewer than this many of the smallest ranges per worker are not measured; they cost little more
+      // than their dispatch, and their timings say nothing about the grain.
+      static constexpr usize  MinRangesPerWorker = 4;
+
+      const char  *m_Name;
+      usize       m_MinGrain;
+      usize       m_MaxGrain;
+      Parameters  m_Best;
+      Parameters  m_Trial;
+      bool        m_Settled = false;
+      bool        m_Improved = false;   // Whether this round has moved yet.
+      uint        m_Neighbour = 0;      // The neighbour being tried.
+      uint        m_Calls = 0;          // Calls into the current trial; odd ones run the neighbour.
+      int64       m_BestNanoseconds = 0;
+      int64       m_TrialNanoseconds = 0;
+      usize       m_BestElements = 0;
+      usize       m_TrialElements = 0;
+      uint        m_SettledCalls = 0;
+      usize       m_SettledCount = 0;   // The population it settled at.
+      Parameters  m_SettledAt{};        // The choice it last settled on, so that settling again on it is not logged.
+
+      bool neighbour(uint index, Parameters &parameters) const;
+      void begin_round();
+      void begin_trial();
+      void settle(usize count);
+      bool measuring(usize count);
+      void record(usize count, int64 nanoseconds);
+      usize grain(const Parameters &parameters, usize count) const;
+
+   public:
+      PhaseTuner(const char *name, usize grain, usize minGrain, usize maxGrain);
+
+      // The choice the tuner last settled on or is moving from.
+      const Parameters &parameters() const
+      {
+         return m_Best;
+      }
+
+      // Scheduler::parallel_for, with the grain and workers the tuner picks. Calls must not overlap.
+      template <typename F>
+      void parallel_for(usize count, const F &fn)
+      {
+         Scheduler &scheduler = Scheduler::get();
+         if (!measuring(count))
+         {
+            scheduler.parallel_for(count, grain(m_Best, count), fn);
+            return;
+         }
+
+         const Parameters &parameters = (m_Calls & 1) ? m_Trial : m_Best;
+         const clock::time_point start = clock::get_current_time();
+         scheduler.parallel_for(count, grain(parameters, count), fn);
+         record(count, int64(clock::get_current_time() - start));
+      }
+   };
+}
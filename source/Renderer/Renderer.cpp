@@ -251,6 +251,10 @@ void Renderer::render_ui()
 		statsString += string::format("  Render Copy  : %*s\n", m_UIData.renderUpdateTime.unicode() ? 10 : 9, m_UIData.renderUpdateTime.to_string());
 		statsString += string::format("  Synch Step   : %*s\n", m_UIData.postTime.unicode() ? 10 : 9, m_UIData.postTime.to_string());
 		statsString += string::format("  Light Update : %*s\n", m_UIData.lightTime.unicode() ? 10 : 9, m_UIData.lightTime.to_string());
+		const auto tuning = [](const UIData::PhaseTuning &phase) {
+			return string::format("%u/%u", phase.Grain, phase.Workers);
+		};
+		statsString += string::format("Grain/Workers  : VM %s, Integrate %s, Collide %s, Cells %s\n", tuning(m_UIData.VMTuning), tuning(m_UIData.IntegrateTuning), tuning(m_UIData.CollideTuning), tuning(m_UIData.CellTuning));
 
 		double renderTime = xtd::max(double(int64(m_RenderCPUTime)) / 1'000'000.0, 1.0);
 		statsString += string::format("Render CPU     : %*s (%.2f FPS)\n", m_RenderCPUTime.unicode() ? 10 : 9, m_RenderCPUTime.to_string(), 1'000.0 / renderTime);
@@ -260,6 +264,10 @@ void Renderer::render_ui()
 		statsString += string::format("Parallel Time  : %*s (%2.2f %%%%)\n", m_UIData.parallelTime.unicode() ? 10 : 9, m_UIData.parallelTime.to_string(), 100.0 * (double(int64(m_UIData.parallelTime)) / double(int64(totalSPTime))));
 		statsString += string::format("Cell Count     : %s\n", reformat(string::format("%u", m_UIData.NumCells)));
 		statsString += string::format("Total Cells    : %s\n", reformat(string::format("%u", m_UIData.TotalCells)));
+		statsString += string::format("Unique Genomes : %s\n", reformat(string::format("%llu", m_UIData.UniqueGenomes)));
+		statsString += string::format("Reachable Code : %2.2f %%%% (%s passive genomes)\n", 100.0 * (double(m_UIData.ReachableSlots) / double(xtd::max(m_UIData.GenomeSlots, 1ull))), reformat(string::format("%llu", m_UIData.PassiveGenomes)));
+		statsString += string::format("Genome Memory  : %s / %s KiB\n", reformat(string::format("%llu", m_UIData.GenomeBytesLive / 1024)), reformat(string::format("%llu", m_UIData.GenomeBytesReserved / 1024)));
+		statsString += string::format("Native Genomes : %s (%s KiB, %s mismatches)\n", reformat(string::format("%llu", m_UIData.NativeGenomes)), reformat(string::format("%llu", m_UIData.NativeCodeBytes / 1024)), reformat(string::format("%llu", m_UIData.NativeMismatches)));
 		statsString += string::format("Current Tick   : %s\n", reformat(string::format("%llu", m_UIData.CurTick)));
 
 		ImGui::Text(statsString.data());
@@ -593,6 +601,26 @@ void Renderer::render_ui()
 		tooltip("maximum energy cost for a split instruction");
 		ImGui::DragInt("Base Growth Cost", &optionsDelta.BaseGrowCost, 1, 1, 1000000);
 		tooltip("maximum energy cost for a growth instruction");
+		int executionMode = int(optionsDelta.ExecutionMode);
+		if (ImGui::Combo("VM Execution", &executionMode, "Per Cell\0Lockstep\0Bucketed\0"))
+		{
+			optionsDelta.ExecutionMode = options::VMExecution(executionMode);
+		}
+		tooltip("per cell interprets every cell on its own; lockstep runs cells sharing a genome and position together; bucketed groups cells by instruction (native code is only used per cell)");
+		ImGui::DragInt("Instructions Per Tick", &optionsDelta.InstructionsPerTick, 1, 1, 256);
+		tooltip("instructions a cell may run each tick: register instructions run back to back, and the first that acts on the cell or the world ends the tick (forces per cell execution above 1)");
+		ImGui::Checkbox("Native Code Tier", &optionsDelta.NativeTier);
+		tooltip("compile frequently executed genomes to native code");
+		ImGui::DragInt("Native Tier Threshold", &optionsDelta.NativeTierThreshold, 1000, 0, 1000000000);
+		tooltip("instructions a genome must execute, summed over all cells running it, before it is compiled");
+		ImGui::Checkbox("Verify Native Code", &optionsDelta.NativeTierVerify);
+		tooltip("also run the interpreter for compiled instructions and count any disagreement (slow)");
+		ImGui::Checkbox("Profile VM", &optionsDelta.VMProfiling);
+		tooltip("sample instruction timings and per-genome hot spots; the report is written to vm_profile.txt when this is turned off (forces per cell execution)");
+		ImGui::DragInt("Serial Cell Threshold", &optionsDelta.SerialCellThreshold, 16, 0, 1000000);
+		tooltip("populations below this tick on the simulation thread alone, since waking the workers would cost more than the work (0 measures it)");
+		ImGui::Checkbox("Fused Tick", &optionsDelta.FusedTick);
+		tooltip("run the VM, physics and cell updates a block of the world at a time while it is in cache, rather than each over every cell (forces per cell execution)");
 		ImGui::PopItemWidth();
 
 		bool apply = false;
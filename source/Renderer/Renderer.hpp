@@ -30,8 +30,24 @@ namespace phylo
 
       struct UIData
       {
+         // What a phase's tuner picked; see PhaseTuner.
+         struct PhaseTuning
+         {
+            uint32 Grain = 0;
+            uint32 Workers = 0;
+         };
+
          uint64		      TotalCells = 0;
          uint64			  CurTick = 0;
+         uint64         UniqueGenomes = 0;
+         uint64         GenomeSlots = 0;
+         uint64         ReachableSlots = 0;
+         uint64         PassiveGenomes = 0;
+         uint64         GenomeBytesLive = 0;
+         uint64         GenomeBytesReserved = 0;
+         uint64         NativeGenomes = 0;
+         uint64         NativeCodeBytes = 0;
+         uint64         NativeMismatches = 0;
          clock::time_span totalTime;
          clock::time_span vmTime;
          clock::time_span physicsTime;
@@ -41,6 +57,10 @@ namespace phylo
          clock::time_span lightTime;
          clock::time_span parallelTime;
          clock::time_span serialTime;
+         PhaseTuning    VMTuning;
+         PhaseTuning    IntegrateTuning;
+         PhaseTuning    CollideTuning;
+         PhaseTuning    CellTuning;
          uint NumCells = 0;
          uint speedState = 4;
       };
@@ -0,0 +1,635 @@
+#include "phylogen.hpp"
+#include "Scheduler.hpp"
+
+#include <chrono>
+#include <Windows.h>
+
+using namespace phylo;
+
+namespace
+{
+   static constexpr usize NotAWorker = traits<usize>::max;
+   static constexpr uint WarmupPhases = 100;
+
+   // A task is a job slot in the top byte and a [begin, end) range in 28 bits each.
+   static constexpr uint RangeBits = 28;
+   static constexpr uint64 RangeMask = (1ull << RangeBits) - 1;
+
+   // The worker the current thread is running as, if it is inside a parallel_for or a graph.
+   static thread_local usize t_WorkerID = NotAWorker;
+
+   static Scheduler::Configuration s_Configuration;
+   static bool s_Started = false;
+
+   static uint64 pack_task(uint slot, usize begin, usize end)
+   {
+      return (uint64(slot) << (RangeBits * 2)) | (uint64(begin) << RangeBits) | uint64(end);
+   }
+
+   static void unpack_task(uint64 task, uint &slot, usize &begin, usize &end)
+   {
+      slot = uint(task >> (RangeBits * 2));
+      begin = usize((task >> RangeBits) & RangeMask);
+      end = usize(task & RangeMask);
+   }
+}
+
+bool Scheduler::Deque::push(uint64 task)
+{
+   const int64 bottom = m_Bottom.load(std::memory_order_relaxed);
+   const int64 top = m_Top.load(std::memory_order_acquire);
+   // Thieves only ever raise m_Top, so a stale one errs towards full.
+   if ((bottom - top) >= int64(DequeCapacity)) [[unlikely]]
+   {
+      return false;
+   }
+   m_Tasks[bottom % DequeCapacity].store(task, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_release);
+   m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+   return true;
+}
+
+bool Scheduler::Deque::pop(uint64 &task)
+{
+   const int64 bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+   m_Bottom.store(bottom, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   int64 top = m_Top.load(std::memory_order_relaxed);
+
+   if (top > bottom)
+   {
+      m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+      return false;
+   }
+
+   task = m_Tasks[bottom % DequeCapacity].load(std::memory_order_relaxed);
+   if (top == bottom)
+   {
+      // The last task, which a thief may be taking at the same time.
+      const bool won = m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+      return won;
+   }
+   return true;
+}
+
+bool Scheduler::Deque::steal(uint64 &task)
+{
+   int64 top = m_Top.load(std::memory_order_acquire);
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   const int64 bottom = m_Bottom.load(std::memory_order_acquire);
+
+   if (top >= bottom)
+   {
+      return false;
+   }
+
+   task = m_Tasks[top % DequeCapacity].load(std::memory_order_relaxed);
+   return m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+void Scheduler::Mailbox::push(uint64 task)
+{
+   scoped_lock _lock(m_Lock);
+   m_Tasks.push_back(task);
+   m_Count.store(uint32(m_Tasks.size()), std::memory_order_release);
+}
+
+bool Scheduler::Mailbox::pop(uint64 &task)
+{
+   if (m_Count.load(std::memory_order_acquire) == 0)
+   {
+      return false;
+   }
+
+   scoped_lock _lock(m_Lock);
+   if (m_Tasks.size() == 0)
+   {
+      return false;
+   }
+   task = m_Tasks.back();
+   m_Tasks.pop_back();
+   m_Count.store(uint32(m_Tasks.size()), std::memory_order_release);
+   return true;
+}
+
+void Scheduler::configure(const Configuration &configuration)
+{
+   xassert(!s_Started, "the scheduler is already running");
+   s_Configuration = configuration;
+}
+
+Scheduler &Scheduler::get()
+{
+   static Scheduler scheduler;
+   return scheduler;
+}
+
+usize Scheduler::current_worker()
+{
+   xassert(t_WorkerID != NotAWorker, "not running on the scheduler");
+   return t_WorkerID;
+}
+
+Scheduler::Scheduler()
+{
+   s_Started = true;
+
+   const array<uint> processors = Topology::get().order(s_Configuration.Pinning, s_Configuration.SMT, s_Configuration.Processors);
+   m_WorkerCount = max((s_Configuration.Workers != 0) ? s_Configuration.Workers : usize(processors.size()), usize(1));
+   m_ActiveWorkers = m_WorkerCount;
+   m_Activation.store(uint32(m_ActiveWorkers));
+   if ((s_Configuration.Pinning != Topology::Pinning::None) & (processors.size() != 0))
+   {
+      m_WorkerProcessors.resize(m_WorkerCount);
+      for (usize workerID = 0; workerID < m_WorkerCount; ++workerID)
+      {
+         m_WorkerProcessors[workerID] = processors[workerID % processors.size()];
+      }
+   }
+   m_Deques.reset(new Deque[m_WorkerCount]);
+
+   // Nodes are numbered in the order their first worker comes in, so worker 0's is node 0.
+   m_WorkerNodes.resize(m_WorkerCount, 0);
+   if (s_Configuration.Numa & (m_WorkerProcessors.size() != 0))
+   {
+      array<uint32> nodes;
+      for (usize workerID = 0; workerID < m_WorkerCount; ++workerID)
+      {
+         const uint32 node = Topology::get().processors()[m_WorkerProcessors[workerID]].Node;
+         usize index = 0;
+         while ((index < nodes.size()) && (nodes[index] != node))
+         {
+            ++index;
+         }
+         if (index == nodes.size())
+         {
+            nodes.push_back(node);
+         }
+         m_WorkerNodes[workerID] = uint(index);
+      }
+      m_NodeCount = nodes.size();
+   }
+   m_Mailboxes.reset(new Mailbox[m_NodeCount]);
+
+   // Everyone starts with the worker after themselves, so thieves do not all go for the same victim.
+   m_StealOrder.resize(m_WorkerCount);
+   for (usize workerID = 0; workerID < m_WorkerCount; ++workerID)
+   {
+      for (bool sameNode : { true, false })
+      {
+         for (usize i = 1; i < m_WorkerCount; ++i)
+         {
+            const usize victim = (workerID + i) % m_WorkerCount;
+            if ((m_WorkerNodes[victim] == m_WorkerNodes[workerID]) == sameNode)
+            {
+               m_StealOrder[workerID].push_back(victim);
+            }
+         }
+      }
+   }
+
+   // Worker 0 is whichever thread calls in, so only the others get threads of their own.
+   m_Workers.resize(m_WorkerCount - 1);
+   usize workerID = 1;
+   for (thread &worker : m_Workers)
+   {
+      worker = [=, this] { worker_func(workerID); };
+      worker.set_name(string("Worker ") + string::from(workerID));
+      worker.start();
+
+      ++workerID;
+   }
+}
+
+Scheduler::~Scheduler()
+{
+   m_Alive = false;
+   m_Generation.fetch_add(1);
+   m_Activation.fetch_add(1);
+
+   for (thread &worker : m_Workers)
+   {
+      worker.join();
+   }
+}
+
+uint Scheduler::acquire_job(Thunk function, const void *context, usize grain, usize count)
+{
+   xassert(count <= usize(RangeMask), "parallel_for range too large");
+   // Waiting for a slot could wait on the very workers that are waiting for one, so with none free the caller runs
+   // its work itself.
+   for (uint slot = 0; slot < MaxJobs; ++slot)
+   {
+      Job &job = m_Jobs[slot];
+      bool inUse = false;
+      if (job.InUse.compare_exchange_strong(inUse, true, std::memory_order_acquire, std::memory_order_relaxed))
+      {
+         job.Function = function;
+         job.Context = context;
+         job.Grain = grain;
+         job.Remaining.store(count, std::memory_order_relaxed);
+         return slot;
+      }
+   }
+   return NoJob;
+}
+
+void Scheduler::release_job(uint slot)
+{
+   m_Jobs[slot].InUse.store(false, std::memory_order_release);
+}
+
+void Scheduler::worker_func(usize workerID)
+{
+   if (m_WorkerProcessors.size())
+   {
+      Topology::get().pin_current_thread(m_WorkerProcessors[workerID]);
+   }
+
+   t_WorkerID = workerID;
+   // Not whatever the word holds by now: a call may have been made before this thread got here.
+   uint32 generation = 0;
+   for (;;)
+   {
+      generation = m_Generation.wait(generation);
+
+      if (!m_Alive)
+      {
+         return;
+      }
+
+      // Set before the call that woke us, so the wake made it visible. NoJob is set_active_workers dropping some of
+      // us; the count can only change once every worker it woke is done, so it has to be read first.
+      const uint slot = m_RootJob.load(std::memory_order_acquire);
+      if (slot != NoJob)
+      {
+         help(slot, workerID);
+      }
+      const bool dropped = (workerID >= m_ActiveWorkers);
+
+      m_Busy.fetch_sub(1);
+
+      if (dropped)
+      {
+         for (uint32 active = m_Activation.load(); (workerID >= active) & bool(m_Alive);)
+         {
+            active = m_Activation.wait(active);
+         }
+         if (!m_Alive)
+         {
+            return;
+         }
+         // Calls since we were dropped neither woke nor counted us, so we pick up from when we were taken back.
+         generation = m_ActivationGeneration;
+      }
+   }
+}
+
+void Scheduler::set_active_workers(usize count)
+{
+   xassert(t_WorkerID == NotAWorker, "set_active_workers called from inside a call");
+   scoped_lock _lock(m_CallerLock);
+
+   count = min(max(count, usize(1)), m_WorkerCount);
+   const usize previous = m_ActiveWorkers;
+   if (count == previous)
+   {
+      return;
+   }
+
+   m_ActiveWorkers = count;
+   if (count < previous)
+   {
+      // The dropped workers check m_Activation as soon as they are woken, so it goes first. Everyone waiting on
+      // m_Generation has to see this wake before the next one, so it is waited out like a call.
+      m_Activation.store(uint32(count));
+      m_RootJob.store(NoJob, std::memory_order_relaxed);
+      m_Busy.store(uint32(previous - 1));
+      m_Generation.fetch_add(1);
+      for (uint32 busy = m_Busy.load(); busy != 0;)
+      {
+         busy = m_Busy.wait(busy);
+      }
+   }
+   else
+   {
+      m_ActivationGeneration = m_Generation.load();
+      m_Activation.store(uint32(count));
+   }
+}
+
+void Scheduler::pin_caller() const
+{
+   if (m_WorkerProcessors.size())
+   {
+      Topology::get().pin_current_thread(m_WorkerProcessors[0]);
+   }
+}
+
+void Scheduler::execute(uint64 task, usize workerID)
+{
+   uint slot;
+   usize begin, end;
+   unpack_task(task, slot, begin, end);
+   Job &job = m_Jobs[slot];
+
+   while ((end - begin) > job.Grain)
+   {
+      // With the deque full, the rest of the range is simply run here.
+      const usize middle = begin + ((end - begin) / 2);
+      if (!m_Deques[workerID].push(pack_task(slot, middle, end)))
+      {
+         break;
+      }
+      end = middle;
+   }
+
+   job.Function(job.Context, begin, end, workerID);
+   job.Remaining.fetch_sub(end - begin, std::memory_order_acq_rel);
+}
+
+void Scheduler::help(uint slot, usize workerID)
+{
+   const Job &job = m_Jobs[slot];
+   Deque &own = m_Deques[workerID];
+   Mailbox &mailbox = m_Mailboxes[m_WorkerNodes[workerID]];
+   while (job.Remaining.load(std::memory_order_acquire) != 0)
+   {
+      uint64 task;
+      if (own.pop(task) || mailbox.pop(task))
+      {
+         execute(task, workerID);
+         continue;
+      }
+
+      // Try everyone else once, our own node first. What we find need not belong to this job; running it still
+      // brings this job closer, as nothing else is left for us to do.
+      bool stolen = false;
+      for (usize victim : m_StealOrder[workerID])
+      {
+         if (m_Deques[victim].steal(task))
+         {
+            stolen = true;
+            break;
+         }
+      }
+      if (stolen)
+      {
+         execute(task, workerID);
+      }
+      else
+      {
+         // Whatever is left is already running elsewhere.
+         YieldProcessor();
+      }
+   }
+}
+
+void Scheduler::run_root(uint slot)
+{
+   m_RootJob.store(slot, std::memory_order_relaxed);
+   m_Busy.store(uint32(m_ActiveWorkers - 1));
+   m_Generation.fetch_add(1);
+   help(slot, 0);
+
+   // Workers may still be looking for tasks to steal; the job's state must outlive them.
+   for (uint32 busy = m_Busy.load(); busy != 0;)
+   {
+      busy = m_Busy.wait(busy);
+   }
+}
+
+void Scheduler::run_inline(usize count, usize grain, Thunk thunk, const void *context, usize workerID)
+{
+   for (usize begin = 0; begin < count; begin += grain)
+   {
+      thunk(context, begin, min(begin + grain, count), workerID);
+   }
+}
+
+void Scheduler::run(usize count, usize grain, Thunk thunk, const void *context)
+{
+   if (count == 0)
+   {
+      return;
+   }
+
+   grain = max(grain, usize(1));
+   if (count > grain)
+   {
+      m_Dispatches.fetch_add(1, std::memory_order_relaxed);
+   }
+   const usize workerID = t_WorkerID;
+   if (workerID != NotAWorker)
+   {
+      // Nested inside a parallel_for or a graph task, so the workers are already up.
+      if ((count <= grain) | m_Serial)
+      {
+         run_inline(count, grain, thunk, context, workerID);
+         return;
+      }
+
+      const uint slot = acquire_job(thunk, context, grain, count);
+      if (slot == NoJob)
+      {
+         run_inline(count, grain, thunk, context, workerID);
+         return;
+      }
+      if (!m_Deques[workerID].push(pack_task(slot, 0, count)))
+      {
+         // Running it as a task still splits what fits back onto the deque.
+         execute(pack_task(slot, 0, count), workerID);
+      }
+      help(slot, workerID);
+      release_job(slot);
+      return;
+   }
+
+   // Callers from different threads take turns, since both would be worker 0.
+   scoped_lock _lock(m_CallerLock);
+
+   t_WorkerID = 0;
+   if ((count <= grain) | (m_ActiveWorkers == 1) | m_Serial)
+   {
+      // Not worth waking anyone for.
+      run_inline(count, grain, thunk, context, 0);
+   }
+   else
+   {
+      const uint slot = acquire_job(thunk, context, grain, count);
+      if (slot == NoJob)
+      {
+         run_inline(count, grain, thunk, context, 0);
+      }
+      else
+      {
+         if (!m_Deques[0].push(pack_task(slot, 0, count)))
+         {
+            execute(pack_task(slot, 0, count), 0);
+         }
+         run_root(slot);
+         release_job(slot);
+      }
+   }
+   t_WorkerID = NotAWorker;
+}
+
+void Scheduler::run_task(const void *context, usize begin, usize end, usize workerID)
+{
+   // Graph jobs have a grain of one, so this is always a single task.
+   TaskGraph &graph = *const_cast<TaskGraph *>(static_cast<const TaskGraph *>(context));
+   TaskGraph::Task &task = graph.m_Tasks[begin];
+   task.Function();
+
+   // Successors are pushed before the job counts this task as done, so it cannot finish with them unrun.
+   Scheduler &scheduler = get();
+   for (TaskGraph::TaskID successor : task.Successors)
+   {
+      if (std::atomic_ref<uint32>(graph.m_Tasks[successor].Pending).fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+         scheduler.push_graph_task(graph, successor, workerID);
+      }
+   }
+}
+
+void Scheduler::push_graph_task(const TaskGraph &graph, TaskGraph::TaskID id, usize workerID)
+{
+   const uint64 task = pack_task(graph.m_JobSlot, id, id + 1);
+   const uint32 node = graph.m_Tasks[id].Node;
+   // Deques can be stolen from by anyone, so a task bound to a node always goes through its mailbox.
+   if ((m_NodeCount > 1) & (node != TaskGraph::AnyNode) & (m_ActiveWorkers == m_WorkerCount))
+   {
+      m_Mailboxes[node % m_NodeCount].push(task);
+   }
+   else if (!m_Deques[workerID].push(task))
+   {
+      // The task is ready, so with nowhere to put it, it runs now.
+      execute(task, workerID);
+   }
+}
+
+void Scheduler::run_graph(TaskGraph &graph)
+{
+   const usize count = graph.m_Tasks.size();
+   if (count == 0)
+   {
+      return;
+   }
+   m_Dispatches.fetch_add(1, std::memory_order_relaxed);
+
+   const usize callerID = t_WorkerID;
+   const bool nested = (callerID != NotAWorker);
+   // Tasks were added in a valid order.
+   const auto run_in_order = [&graph] {
+      for (TaskGraph::Task &task : graph.m_Tasks)
+      {
+         task.Function();
+      }
+   };
+   if (m_Serial | (m_ActiveWorkers == 1))
+   {
+      if (nested)
+      {
+         run_in_order();
+         return;
+      }
+
+      scoped_lock _lock(m_CallerLock);
+      t_WorkerID = 0;
+      run_in_order();
+      t_WorkerID = NotAWorker;
+      return;
+   }
+
+   for (TaskGraph::Task &task : graph.m_Tasks)
+   {
+      task.Pending = task.Dependencies;
+   }
+
+   const auto push_roots = [&](usize workerID) {
+      for (usize i = 0; i < count; ++i)
+      {
+         if (graph.m_Tasks[i].Dependencies == 0)
+         {
+            push_graph_task(graph, TaskGraph::TaskID(i), workerID);
+         }
+      }
+   };
+
+   if (nested)
+   {
+      graph.m_JobSlot = acquire_job(&run_task, &graph, 1, count);
+      if (graph.m_JobSlot == NoJob)
+      {
+         run_in_order();
+         return;
+      }
+      push_roots(callerID);
+      help(graph.m_JobSlot, callerID);
+      release_job(graph.m_JobSlot);
+      return;
+   }
+
+   scoped_lock _lock(m_CallerLock);
+   t_WorkerID = 0;
+   graph.m_JobSlot = acquire_job(&run_task, &graph, 1, count);
+   if (graph.m_JobSlot == NoJob)
+   {
+      run_in_order();
+   }
+   else
+   {
+      push_roots(0);
+      run_root(graph.m_JobSlot);
+      release_job(graph.m_JobSlot);
+   }
+   t_WorkerID = NotAWorker;
+}
+
+void Scheduler::run_graph_on_nodes(TaskGraph &graph)
+{
+   xassert(t_WorkerID == NotAWorker, "run_graph_on_nodes called from inside a call");
+
+   // Serial or with fewer workers, run_graph would leave node-bound tasks to whoever gets to them first.
+   const bool serial = m_Serial;
+   const usize activeWorkers = m_ActiveWorkers;
+   m_Serial = false;
+   set_active_workers(m_WorkerCount);
+
+   run_graph(graph);
+
+   set_active_workers(activeWorkers);
+   m_Serial = serial;
+}
+
+Scheduler::DispatchTiming Scheduler::measure_dispatch(uint phases)
+{
+   using bench_clock = std::chrono::steady_clock;
+
+   phases = max(phases, 1u);
+   array<double> samples;
+   samples.resize(phases);
+
+   // One range per worker, so every worker is woken and waited for.
+   const usize count = m_WorkerCount;
+   // The first few wake every worker from the kernel; those are not what a running simulation sees.
+   for (uint i = 0; i < WarmupPhases; ++i)
+   {
+      parallel_for(count, 1, [](usize, usize, usize) {});
+   }
+   for (double &sample : samples)
+   {
+      const bench_clock::time_point start = bench_clock::now();
+      parallel_for(count, 1, [](usize, usize, usize) {});
+      sample = std::chrono::duration<double, std::micro>(bench_clock::now() - start).count();
+   }
+
+   std::sort(samples.data(), samples.data() + samples.size());
+   return {
+      samples[0],
+      samples[samples.size() / 2],
+      samples[min(usize(double(samples.size()) * 0.99), samples.size() - 1)],
+      samples[samples.size() - 1]
+   };
+}
@@ -0,0 +1,379 @@
+#pragma once
+
+#include <xtd/xtd>
+#include <atomic>
+#include <initializer_list>
+#include <memory>
+#include <new>
+
+#include "Parking.hpp"
+#include "Topology.hpp"
+
+namespace phylo
+{
+   // A set of tasks and the order they must run in, for Scheduler::run_graph. Tasks that do not depend on each other,
+   // directly or otherwise, may run at the same time, and a task may itself call parallel_for. A graph can be run any
+   // number of times.
+   class TaskGraph final
+   {
+      friend class Scheduler;
+
+   public:
+      using TaskID = uint;
+      static constexpr uint32 AnyNode = traits<uint32>::max;
+
+   private:
+      struct Task final
+      {
+         function<void()> Function;
+         array<TaskID>    Successors;
+         uint32           Dependencies = 0;
+         uint32           Pending = 0;    // Dependencies still running; only touched through atomic_ref while running.
+         uint32           Node = AnyNode;
+      };
+
+      array<Task> m_Tasks;
+      uint        m_JobSlot = 0;
+
+   public:
+      // Adds a task that runs once everything in 'after' has. Tasks can only depend on tasks added before them, so
+      // the order they are added in is always a valid serial order.
+      TaskID add(function<void()> &&fn, std::initializer_list<TaskID> after = {})
+      {
+         const TaskID id = TaskID(m_Tasks.size());
+         m_Tasks.push_back({ std::move(fn), {}, uint32(after.size()), 0 });
+         for (TaskID predecessor : after)
+         {
+            xassert(predecessor < id, "tasks can only depend on earlier tasks");
+            m_Tasks[predecessor].Successors.push_back(id);
+         }
+         return id;
+      }
+
+      // Makes 'task' wait for 'predecessor' as well, for dependencies that do not fit in an initializer list.
+      void add_dependency(TaskID task, TaskID predecessor)
+      {
+         xassert(predecessor < task, "tasks can only depend on earlier tasks");
+         m_Tasks[predecessor].Successors.push_back(task);
+         ++m_Tasks[task].Dependencies;
+      }
+
+      // Runs the task only on the workers of one NUMA node, numbered as Scheduler::node_count() counts them. This
+      // only has an effect when the scheduler places work by node.
+      void set_node(TaskID task, uint32 node)
+      {
+         m_Tasks[task].Node = node;
+      }
+   };
+
+   // The process-wide worker pool every parallel phase runs on. By default there is one worker per logical processor,
+   // each pinned to its own, and the thread calling into it takes part as worker 0, so the cores are never
+   // oversubscribed. configure() changes how many workers there are and where they go.
+   //
+   // parallel_for hands the whole range to the caller's deque. Whoever pops a range larger than the grain splits it
+   // in half, pushes the upper half and keeps going with the lower, so idle workers always find large ranges to steal
+   // from the top of a deque while the owner works through small ones at the bottom. A worker waiting for a nested
+   // parallel_for or a graph to finish keeps running whatever it can find in the meantime.
+   class Scheduler final
+   {
+      // Ranges are halved until they fit the grain, so a job leaves at most one range per bit of its count in a
+      // deque; nesting stacks jobs on top of each other. A graph task pushes every task it makes ready, and a graph
+      // starts with all of its roots in one deque.
+      static constexpr uint DequeCapacity = 1024;
+      // Jobs running at once: the outermost call, plus every nested parallel_for still in progress. A call that finds
+      // its deque full, or no job free, runs inline instead.
+      static constexpr uint MaxJobs = 64;
+      static constexpr uint NoJob = MaxJobs;
+
+      using Thunk = void (*)(const void *context, usize begin, usize end, usize workerID);
+
+      // A Chase-Lev deque of tasks, each a job slot and a [begin, end) range packed into a word. The owner pushes and
+      // pops at the bottom, thieves steal from the top. The memory orders are those of Le et al.'s C11 formulation,
+      // which xtd's atomic does not expose, hence std::atomic.
+      class alignas(64) Deque final
+      {
+         std::atomic<int64>  m_Top = 0;
+         std::atomic<int64>  m_Bottom = 0;
+         std::atomic<uint64> m_Tasks[DequeCapacity];
+
+      public:
+         // Returns false, leaving the task to the caller, when the deque is full.
+         bool push(uint64 task);
+         bool pop(uint64 &task);
+         bool steal(uint64 &task);
+      };
+
+      // Graph tasks bound to a node wait here for one of its workers. Those are coarse, so a lock is cheap enough.
+      class alignas(64) Mailbox final
+      {
+         mutex               m_Lock;
+         array<uint64>       m_Tasks;
+         std::atomic<uint32> m_Count = 0;
+
+      public:
+         void push(uint64 task);
+         bool pop(uint64 &task);
+      };
+
+      struct alignas(64) Job final
+      {
+         Thunk              Function = nullptr;
+         const void         *Context = nullptr;
+         usize              Grain = 1;
+         std::atomic<usize> Remaining = 0;     // Elements not yet run; the job is done at zero.
+         std::atomic<bool>  InUse = false;
+      };
+
+      usize             m_WorkerCount;
+      usize             m_ActiveWorkers;    // Workers past this sit calls out, parked on m_Activation.
+      array<uint>       m_WorkerProcessors; // The processor each worker is pinned to; empty if they are not pinned.
+      array<uint>       m_WorkerNodes;      // The node each worker is on, counted from 0; all 0 unless placing by node.
+      usize             m_NodeCount = 1;
+      array<array<usize>> m_StealOrder;     // Per worker, whom to steal from: its own node's workers first.
+      array<thread>     m_Workers;
+      // Deques and mailboxes are neither copyable nor movable, so they do not go in an array<>.
+      std::unique_ptr<Deque[]> m_Deques;
+      std::unique_ptr<Mailbox[]> m_Mailboxes; // One per node.
+      Job               m_Jobs[MaxJobs];
+      ParkingWord       m_Generation;  // Bumped to wake the workers for an outermost call.
+      ParkingWord       m_Busy;        // Workers that have not yet finished the outermost call.
+      ParkingWord       m_Activation;  // m_ActiveWorkers, for the workers waiting to be taken back.
+      uint32            m_ActivationGeneration = 0; // m_Generation when they were; they pick up from there.
+      std::atomic<uint> m_RootJob = 0; // The outermost call's job; the workers go back to sleep once it is done.
+      atomic<bool>      m_Alive = true;
+      mutex             m_CallerLock;
+      bool              m_Serial = false;
+      std::atomic<uint64> m_Dispatches = 0;
+
+      Scheduler();
+      ~Scheduler();
+
+      uint acquire_job(Thunk function, const void *context, usize grain, usize count);
+      void release_job(uint slot);
+
+      void worker_func(usize workerID);
+      void help(uint slot, usize workerID);
+      void execute(uint64 task, usize workerID);
+      void run_root(uint slot);
+      void push_graph_task(const TaskGraph &graph, TaskGraph::TaskID id, usize workerID);
+
+      void run(usize count, usize grain, Thunk thunk, const void *context);
+      static void run_inline(usize count, usize grain, Thunk thunk, const void *context, usize workerID);
+      static void run_task(const void *context, usize begin, usize end, usize workerID);
+
+   public:
+      struct Configuration final
+      {
+         usize             Workers = 0;      // Counting the caller. 0 means one per processor the placement allows.
+         bool              SMT = true;       // Whether workers may share a core.
+         Topology::Pinning Pinning = Topology::Pinning::Compact;
+         array<uint>       Processors;       // For Topology::Pinning::List. Workers past its end wrap around.
+         bool              Numa = false;     // Steal from the same node first, and honour TaskGraph::set_node.
+      };
+
+      // Round-trip latencies of empty parallel_for calls, in microseconds.
+      struct DispatchTiming final
+      {
+         double Min;
+         double Median;
+         double P99;
+         double Max;
+      };
+
+      // Takes effect when the scheduler starts, so it must come before the first get().
+      static void configure(const Configuration &configuration);
+      static Scheduler &get();
+
+      usize worker_count() const
+      {
+         return m_WorkerCount;
+      }
+
+      // How many of the workers take part in calls, counting the caller; the rest stay parked until taken back, and
+      // are neither woken nor waited on by calls meanwhile. For measuring how the simulation scales, so it must not
+      // be called from inside a call, and it turns placement by node off until it is back to every worker, as a
+      // node could be left with nobody to run its tasks.
+      void set_active_workers(usize count);
+
+      usize active_worker_count() const
+      {
+         return m_ActiveWorkers;
+      }
+
+      // The worker the calling thread is running as inside a parallel_for or a graph task, with the same guarantees
+      // as the workerID parallel_for passes.
+      static usize current_worker();
+
+      // NUMA nodes the workers are on, when placing work by node; otherwise 1.
+      usize node_count() const
+      {
+         return m_NodeCount;
+      }
+
+      usize node_worker_count(uint node) const
+      {
+         usize count = 0;
+         for (uint workerNode : m_WorkerNodes)
+         {
+            count += (workerNode == node);
+         }
+         return count;
+      }
+
+      // Pins the calling thread where worker 0 belongs, for the thread that is going to be calling in.
+      void pin_caller() const;
+
+      // While set, parallel_for and run_graph run everything inline on the caller as worker 0.
+      void set_serial(bool serial)
+      {
+         m_Serial = serial;
+      }
+
+      bool is_serial() const
+      {
+         return m_Serial;
+      }
+
+      // parallel_for calls with more than a grain of work, and run_graph calls, made so far; each would have split
+      // across the workers even where it ran inline. The difference across a call counts the dispatches it made.
+      uint64 dispatch_count() const
+      {
+         return m_Dispatches.load(std::memory_order_relaxed);
+      }
+
+      // Calls fn(begin, end, workerID) over disjoint subranges of [0, count) no longer than 'grain', and returns once
+      // all of them have run. workerID is below worker_count() and no two calls running at once share it, so it can
+      // index per-worker state; a worker waiting on a nested call may run other ranges meanwhile, so that state must
+      // not be held across one.
+      template <typename F>
+      void parallel_for(usize count, usize grain, const F &fn)
+      {
+         run(count, grain, [](const void *context, usize begin, usize end, usize workerID) {
+            (*static_cast<const F *>(context))(begin, end, workerID);
+         }, &fn);
+      }
+
+      // Runs every task in the graph, each once its dependencies have, and returns when all are done.
+      void run_graph(TaskGraph &graph);
+
+      // As run_graph, but always with every worker and whatever set_serial says, so that tasks set to a node do run
+      // on it. For work whose placement matters more than running it the way the caller asked, such as first touching
+      // memory a node is to keep. Not from inside a call.
+      void run_graph_on_nodes(TaskGraph &graph);
+
+      // Issues 'phases' parallel_for calls that wake every worker and do nothing, which is the fixed cost every phase
+      // of a tick pays.
+      DispatchTiming measure_dispatch(uint phases);
+   };
+
+   // How WorkerLocal lays out the next storage it sizes. Packed leaves each worker's state right after the previous
+   // worker's, as an array would; it is only for measuring what sharing cache lines costs.
+   struct WorkerLocalLayout final
+   {
+      static inline bool Packed = false;
+   };
+
+   // One T per scheduler worker, for state a worker writes while it runs. Each starts on a cache line of its own, so
+   // that no two workers write to the same line.
+   template <typename T>
+   class WorkerLocal final
+   {
+      static constexpr usize CacheLineSize = 64;
+      static_assert(alignof(T) <= CacheLineSize, "WorkerLocal cannot align past a cache line");
+
+      uint8 *m_Storage = nullptr;
+      usize  m_Count = 0;
+      usize  m_Stride = 0;
+
+      void destroy()
+      {
+         for (usize i = 0; i < m_Count; ++i)
+         {
+            (*this)[i].~T();
+         }
+         operator delete[](m_Storage, std::align_val_t(CacheLineSize));
+         m_Storage = nullptr;
+         m_Count = 0;
+      }
+
+   public:
+      template <typename Element, typename Byte>
+      class iterator_base final
+      {
+         Byte  *m_Position;
+         usize m_Stride;
+
+      public:
+         iterator_base(Byte *position, usize stride) : m_Position(position), m_Stride(stride) {}
+
+         Element &operator * () const
+         {
+            return *reinterpret_cast<Element *>(m_Position);
+         }
+         iterator_base &operator ++ ()
+         {
+            m_Position += m_Stride;
+            return *this;
+         }
+         bool operator != (const iterator_base &other) const
+         {
+            return m_Position != other.m_Position;
+         }
+      };
+      using iterator = iterator_base<T, uint8>;
+      using const_iterator = iterator_base<const T, const uint8>;
+
+      WorkerLocal() = default;
+      WorkerLocal(const WorkerLocal &) = delete;
+      WorkerLocal &operator = (const WorkerLocal &) = delete;
+      ~WorkerLocal()
+      {
+         destroy();
+      }
+
+      // Replaces whatever was held with 'count' default-constructed Ts.
+      void resize(usize count)
+      {
+         destroy();
+         m_Stride = WorkerLocalLayout::Packed ? sizeof(T) : ((sizeof(T) + CacheLineSize - 1) & ~(CacheLineSize - 1));
+         m_Storage = new (std::align_val_t(CacheLineSize)) uint8[m_Stride * count];
+         for (; m_Count < count; ++m_Count)
+         {
+            new (m_Storage + (m_Count * m_Stride)) T();
+         }
+      }
+
+      usize size() const
+      {
+         return m_Count;
+      }
+
+      T &operator [] (usize index)
+      {
+         xassert(index < m_Count, "Worker index out of range");
+         return *reinterpret_cast<T *>(m_Storage + (index * m_Stride));
+      }
+      const T &operator [] (usize index) const
+      {
+         xassert(index < m_Count, "Worker index out of range");
+         return *reinterpret_cast<const T *>(m_Storage + (index * m_Stride));
+      }
+
+      iterator begin()
+      {
+         return { m_Storage, m_Stride };
+      }
+      iterator end()
+      {
+         return { m_Storage + (m_Count * m_Stride), m_Stride };
+      }
+      const_iterator begin() const
+      {
+         return { m_Storage, m_Stride };
+      }
+      const_iterator end() const
+      {
+         return { m_Storage + (m_Count * m_Stride), m_Stride };
+      }
+   };
+}
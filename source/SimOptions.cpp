@@ -36,6 +36,17 @@ namespace phylo
       int BaseRotateCost = int((10u) * TimeMultiplier);
       int BaseSplitCost = int((10u) * TimeMultiplier);
       int BaseGrowCost = int((100000u) * TimeMultiplier);
+
+      VMExecution ExecutionMode = VMExecution::PerCell;
+      int InstructionsPerTick = 1;
+
+      bool NativeTier = true;
+      int NativeTierThreshold = 1000000;
+      bool NativeTierVerify = false;
+      bool VMProfiling = false;
+
+      int SerialCellThreshold = 0;
+      bool FusedTick = false;
    }
 
    const options_delta defaultOptions;
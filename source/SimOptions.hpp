@@ -47,6 +47,23 @@ namespace phylo
       extern int BaseSplitCost;
       extern int BaseGrowCost;
 
+      enum class VMExecution : int
+      {
+         PerCell = 0, // Every cell is interpreted on its own.
+         Lockstep,    // Cells sharing a genome and slot execute together.
+         Bucketed,    // Cells are grouped by the opcode they execute, and each group runs through its own loop.
+      };
+      extern VMExecution ExecutionMode;
+      extern int InstructionsPerTick;  // Most instructions a cell runs per tick; only the last may leave the registers.
+
+      extern bool NativeTier;          // Compile hot genomes to native code.
+      extern int NativeTierThreshold;  // Population-weighted executions before a genome is compiled.
+      extern bool NativeTierVerify;    // Run the interpreter alongside native code and count disagreements.
+      extern bool VMProfiling;         // Sample VM execution; the report is written when profiling is turned off.
+
+      extern int SerialCellThreshold;  // Populations below this tick on the sim thread alone; 0 measures it.
+      extern bool FusedTick;           // Run the VM, physics and cells a tile at a time rather than phase by phase.
+
       static constexpr float MinCellSize = 1.0f;
       static constexpr float MaxCellSize = 2.5f;
       static constexpr float MedianCellSize = MaxCellSize;
@@ -92,6 +109,15 @@ namespace phylo
       int BaseSplitCost = options::BaseSplitCost;
       int BaseGrowCost = options::BaseGrowCost;
 
+      options::VMExecution ExecutionMode = options::ExecutionMode;
+      int InstructionsPerTick = options::InstructionsPerTick;
+      bool NativeTier = options::NativeTier;
+      int NativeTierThreshold = options::NativeTierThreshold;
+      bool NativeTierVerify = options::NativeTierVerify;
+      bool VMProfiling = options::VMProfiling;
+      int SerialCellThreshold = options::SerialCellThreshold;
+      bool FusedTick = options::FusedTick;
+
       auto operator <=> (const options_delta& delta) const = default;
 
       void apply()
@@ -121,6 +147,14 @@ namespace phylo
          options::BaseRotateCost = BaseRotateCost;
          options::BaseSplitCost = BaseSplitCost;
          options::BaseGrowCost = BaseGrowCost;
+         options::ExecutionMode = ExecutionMode;
+         options::InstructionsPerTick = InstructionsPerTick;
+         options::NativeTier = NativeTier;
+         options::NativeTierThreshold = NativeTierThreshold;
+         options::NativeTierVerify = NativeTierVerify;
+         options::VMProfiling = VMProfiling;
+         options::SerialCellThreshold = SerialCellThreshold;
+         options::FusedTick = FusedTick;
       }
    };
 
@@ -70,15 +70,11 @@ namespace
 	}
 }
 
-Cell::Cell(const Cell * parent, Simulation &simulation, const vector2F &position, bool initialize) :
-	m_Simulation(simulation),
-	m_RenderInstance(simulation.m_RenderController.insert(this)),
-	m_PhysicsInstance(simulation.m_PhysicsController.insert(this)),
-	m_VMInstance(simulation.m_VMController.insert(this))
+usize Cell::draw_seed(const Cell *parent, const Simulation &simulation, random::source<random::engine::xorshift_plus> &outRandom)
 {
 	uint64 seed[2] = { 0, 0 };
 
-	random::source<random::engine::xorshift_plus> randomg{ m_Simulation.get_hash_seed() };
+	random::source<random::engine::xorshift_plus> randomg{ simulation.get_hash_seed() };
 	auto &random = parent ? parent->getRandom() : randomg;
 
 	for (usize i = 0; i < 2; ++i)
@@ -89,9 +85,78 @@ Cell::Cell(const Cell * parent, Simulation &simulation, const vector2F &position
 		}
 	}
 
-	m_Random.seed(seed[0], seed[1]);
-	m_CellID = m_Random.uniform<uint64>(0, xtd::traits<uint64>::max);
+	outRandom.seed(seed[0], seed[1]);
+	return outRandom.uniform<uint64>(0, xtd::traits<uint64>::max);
+}
+
+Cell::Cell(const Cell * parent, Simulation &simulation, const vector2F &position, bool initialize) :
+	m_Simulation(simulation),
+	m_RenderInstance(simulation.m_RenderController.insert(this)),
+	m_PhysicsInstance(simulation.m_PhysicsController.insert(this)),
+	m_VMInstance(simulation.m_VMController.insert(this))
+{
+	m_CellID = draw_seed(parent, simulation, m_Random);
+
+	construct(position, initialize);
+}
 
+Cell::Cell(const random::source<random::engine::xorshift_plus> &random, usize cellID, Simulation &simulation, const vector2F &position) :
+	m_Random(random),
+	m_CellID(cellID),
+	m_Simulation(simulation),
+	m_RenderInstance(simulation.m_RenderController.insert(this)),
+	m_PhysicsInstance(simulation.m_PhysicsController.insert(this)),
+	m_VMInstance(simulation.m_VMController.insert(this))
+{
+	construct(position, false);
+}
+
+Cell::Cell(Cell &&cell) :
+	m_Random(cell.m_Random),
+	m_CellID(cell.m_CellID),
+	m_NumChildren(cell.m_NumChildren),
+	m_Simulation(cell.m_Simulation),
+	m_RenderInstance(cell.m_RenderInstance),
+	m_PhysicsInstance(cell.m_PhysicsInstance),
+	m_VMInstance(cell.m_VMInstance),
+	m_fVolume(cell.m_fVolume),
+	m_fInvVolume(cell.m_fInvVolume),
+	m_fSuperVolume(cell.m_fSuperVolume),
+	m_fInvSuperVolume(cell.m_fInvSuperVolume),
+	m_fArea(cell.m_fArea),
+	m_fInvArea(cell.m_fInvArea),
+	m_ColorGreen(cell.m_ColorGreen),
+	m_ColorRed(cell.m_ColorRed),
+	m_ColorBlue(cell.m_ColorBlue),
+	m_KilledBy(cell.m_KilledBy),
+	m_Touched(cell.m_Touched),
+	m_Attacked(cell.m_Attacked),
+	m_AttackedRemote(cell.m_AttackedRemote.load()),
+	m_uObjectCapacity(cell.m_uObjectCapacity),
+	m_uEnergy(cell.m_uEnergy),
+	m_Integrity(cell.m_Integrity),
+	m_Armor(cell.m_Armor),
+	m_SelectBrightness(cell.m_SelectBrightness),
+	m_ColorHash1(cell.m_ColorHash1),
+	m_ColorDye(cell.m_ColorDye),
+	m_CellIdx(cell.m_CellIdx),
+	m_TickCollided(cell.m_TickCollided),
+	m_Alive(cell.m_Alive),
+	m_GrowthPoint(cell.m_GrowthPoint),
+	m_MoveState(cell.m_MoveState),
+	m_MoveSpeed(cell.m_MoveSpeed)
+{
+	m_RenderInstance->m_Cell = this;
+	m_PhysicsInstance->m_Cell = this;
+	m_VMInstance->m_Cell = this;
+
+	cell.m_RenderInstance = nullptr;
+	cell.m_PhysicsInstance = nullptr;
+	cell.m_VMInstance = nullptr;
+}
+
+void Cell::construct(const vector2F &position, bool initialize)
+{
 	m_VMInstance->m_Cell = this;
 
 	auto getTransformTemp = [](const vector4F &vec) -> matrix4F
@@ -130,6 +195,12 @@ Cell::Cell(const Cell * parent, Simulation &simulation, const vector2F &position
 
 Cell::~Cell()
 {
+	// Moved from by rehome_cells; the components are the other cell's now.
+	if (!m_VMInstance)
+	{
+		return;
+	}
+
 	m_Simulation.m_VMController.remove(m_VMInstance);
 	m_Simulation.m_PhysicsController.remove(m_PhysicsInstance);
 	m_Simulation.m_RenderController.remove(m_RenderInstance);
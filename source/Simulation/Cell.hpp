@@ -86,8 +86,20 @@ namespace phylo
       bool m_MoveState = false; // Are we moving?
       float m_MoveSpeed = 0.0f;
 
+      void construct(const vector2F &position, bool initialize);
+
+      // Takes over another cell and its components, leaving it with none, so that destroying it afterwards frees
+      // nothing; for Simulation::rehome_cells, which moves cells between node stores.
+      Cell(Cell &&cell);
+
    public:
+      // Seeds a new cell's RNG from its parent's stream (or the simulation's seed for root cells) and draws its ID,
+      // advancing the parent's RNG exactly as constructing a child from it does.
+      static usize draw_seed(const Cell *parent, const Simulation &simulation, random::source<random::engine::xorshift_plus> &outRandom);
+
       Cell(const Cell * parent, Simulation &simulation, const vector2F &position, bool initialize = false);
+      // Constructs a child whose RNG and ID were drawn ahead of time with draw_seed.
+      Cell(const random::source<random::engine::xorshift_plus> &random, usize cellID, Simulation &simulation, const vector2F &position);
       ~Cell();
 
 	  usize getNumChildren() const
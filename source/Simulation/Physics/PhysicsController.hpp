@@ -1,7 +1,8 @@
 #pragma once
 
 #include "PhysicsInstance.hpp"
-#include "ThreadPool.hpp"
+#include "PhaseTuner.hpp"
+#include "Scheduler.hpp"
 #include "Simulation/Controller.hpp"
 
 namespace phylo {
@@ -13,8 +14,17 @@ namespace phylo {
 
 			using instance_t = Physics::Instance;
 
-			void pool_update(usize threadID) __restrict;
-			void pool_update2(usize threadID) __restrict;
+			// How many instances a worker runs at once, to begin with; the tuners move it between the bounds.
+			// If this is too low, cache locality goes down, and the workers spend too much time splitting ranges.
+			// If this is too high, parallelism suffers.
+			static constexpr const uint RunSize = 16;
+			static constexpr const uint MinRunSize = 4;
+			static constexpr const uint MaxRunSize = 4096;
+
+			void integrate(instance_t & __restrict instance) __restrict;
+			void collide(instance_t & __restrict instance) __restrict;
+			void pool_update(usize begin, usize end) __restrict;
+			void pool_update2(usize begin, usize end) __restrict;
 
 			template <uint32 elements>
 			struct InstanceSubArray {
@@ -105,9 +115,11 @@ namespace phylo {
 
 			Simulation& m_Simulation;
 
-			ThreadPool								m_ThreadPool;
-			ThreadPool								m_ThreadPool2;
-			atomic<uint>							m_ThreadPoolIndex;
+			PhaseTuner                                  m_IntegrateTuner;
+			PhaseTuner                                  m_CollideTuner;
+
+			array<array<instance_t *>>                 m_Tiles; // The instances in each tile this tick, for the fused tick.
+			uint32                                      m_TileEdgeCount;
 
 			float                                      m_GridElementSize;
 			float                                      m_GridElementSizeHalf;
@@ -132,6 +144,44 @@ namespace phylo {
 
 			void update() ;
 
+			const PhaseTuner &integrate_tuner() const {
+				return m_IntegrateTuner;
+			}
+			const PhaseTuner &collide_tuner() const {
+				return m_CollideTuner;
+			}
+
+			// The fused tick works through the world a tile at a time: a square block of TileEdge grid elements a side,
+			// numbered in Morton order like the elements, so each is a contiguous run of them. An instance moves at most
+			// ten radii in a tick, and nothing looks more than three radii past it, so whatever a tile's instances touch
+			// lies within the tiles around it.
+			static constexpr const uint32 TileEdge = 16;
+			static constexpr const uint32 TileElements = TileEdge * TileEdge;
+			static_assert(options::MaxCellSize * 13.0f < float(TileEdge) * options::MedianCellSize, "tiles are too small");
+
+			uint32 tile_edge_count() const {
+				return m_TileEdgeCount;
+			}
+
+			uint32 tile_index(uint32 x, uint32 y) const {
+				return xtd::morton2d<uint>(x, y);
+			}
+
+			// The tile an instance is over, which begin_tiles() hands it to.
+			uint32 tile_of(const instance_t &instance) const {
+				return GetInstanceOffset(instance) / TileElements;
+			}
+
+			// begin_tiles() starts a tick. A tile's instances come from its elements, so gather_tile() has to run before
+			// anything can move instances into or out of them: its own integration, or that of the tiles around it.
+			void begin_tiles() __restrict;
+			void gather_tile(uint32 tile) __restrict;
+			const array<instance_t *> &tile_instances(uint32 tile) const {
+				return m_Tiles[tile];
+			}
+			void integrate_tile(uint32 tile) __restrict;
+			void collide_tile(uint32 tile) __restrict;
+
 			Cell *findCell(const vector2F & __restrict position, float radius, const Cell * __restrict filter) const __restrict;
 		};
 	}
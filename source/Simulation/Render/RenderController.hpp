@@ -1,7 +1,6 @@
 #pragma once
 
 #include "RenderInstance.hpp"
-#include "ThreadPool.hpp"
 #include "Simulation/Controller.hpp"
 
 namespace phylo
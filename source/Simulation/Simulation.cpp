@@ -22,8 +22,22 @@ static constexpr float MedianLightCellSize = 5.0f;
 static constexpr float WorldRadius = options::WorldRadius;
 
 static constexpr float MulFactor = 0.01f;
+
+// Elements a scheduler worker processes at once, per phase, to begin with; the tuners move them between the bounds.
+static constexpr usize CellRunSize = 16;
+static constexpr usize MinCellRunSize = 4;
+static constexpr usize MaxCellRunSize = 4096;
+static constexpr usize LightRunSize = 8;
+static constexpr usize MinLightRunSize = 1;
+static constexpr usize MaxLightRunSize = 256;
+static constexpr usize WasteRunSize = 64;
+static constexpr usize MinWasteRunSize = 16;
+static constexpr usize MaxWasteRunSize = 16384;
 #define DYNAMIC_LIGHTS 0
 
+// How often post_update hands genome slabs that have come wholly free back to the heap.
+static constexpr uint64 ArenaTrimTicks = 1024;
+
 string getRandomName()
 {
 	const int64 timeValue = int64(clock::get_current_time() - clock::time_point(0));
@@ -54,43 +68,135 @@ void Simulation::GridProperties::init()
 	}
 }
 
-Cell *Simulation::getNewCellPtr() 
+Cell *Simulation::getNewCellPtr(uint32 node) 
 {
-	uptr nextCell = *(uptr * )m_NextFreeCell;
-	Cell *ret = (Cell * )m_NextFreeCell;
-	m_NextFreeCell = (uint8 * )nextCell;
-	xassert(nextCell != 0, "out of cells to allocate");
-	return ret;
+	// A node whose store has run out borrows from the others'; rehome_cells() moves the cell back once it has room.
+	for (usize i = 0; i < m_CellStores.size(); ++i)
+	{
+		CellStore &store = m_CellStores[(node + i) % m_CellStores.size()];
+		if (store.NextFree)
+		{
+			Cell *ret = (Cell * )store.NextFree;
+			store.NextFree = (uint8 * )*(uptr * )store.NextFree;
+			return ret;
+		}
+	}
+	xassert(false, "out of cells to allocate");
+	return nullptr;
 }
 
 void Simulation::freeCellPtr(Cell *cell) 
 {
-	*(uptr * )cell = uptr(m_NextFreeCell);
-	m_NextFreeCell = (uint8 * )cell;
+	CellStore &store = m_CellStores[store_node(*cell)];
+	*(uptr * )cell = uptr(store.NextFree);
+	store.NextFree = (uint8 * )cell;
+}
+
+uint32 Simulation::store_node(const Cell &cell) const 
+{
+	const uint8 *address = (const uint8 * )&cell;
+	for (uint32 node = 1; node < m_CellStores.size(); ++node)
+	{
+		const CellStore &store = m_CellStores[node];
+		if ((address >= store.Cells) & (address < store.Cells + (usize(store.Capacity) * sizeof(Cell))))
+		{
+			return node;
+		}
+	}
+	return 0;
+}
+
+uint32 Simulation::home_node(const Cell &cell) const 
+{
+	return m_TileNodes[m_PhysicsController.tile_of(*cell.m_PhysicsInstance)];
+}
+
+void Simulation::rehome_cells() 
+{
+	if (m_CellStores.size() == 1)
+	{
+		return;
+	}
+
+	// A cell that has crossed into another node's tile moves to that node's store, if it has room. Only its components,
+	// which the move repoints, and m_Cells point to it. (Nothing reads m_KilledBy, which already outlives the cell it
+	// names when that one is destroyed.)
+	for (uint idx = 0; idx < m_Cells.size(); ++idx)
+	{
+		Cell *cell = m_Cells[idx];
+		const uint32 node = home_node(*cell);
+		if ((store_node(*cell) == node) || !m_CellStores[node].NextFree)
+		{
+			continue;
+		}
+
+		Cell *moved = new (getNewCellPtr(node)) Cell(std::move(*cell));
+		cell->~Cell();
+		freeCellPtr(cell);
+		m_Cells[idx] = moved;
+	}
 }
 
 Simulation::Simulation(event &startProcessing, event &waitThreadProcessing, const loadInitializer &init) :
 	System(),
-	m_ThreadPool("Simulation", [this](usize) {pool_update(); }, false),
-	m_ThreadPool2("Simulation2", [this](usize) {pool_update2(); }, false),
-	m_ThreadPool3("Simulation3", [this](usize) {pool_updatelite(); }, false),
-	m_ThreadPool4("Simulation4", [this](usize) {pool_update_waste(); }, false),
 	m_PhysicsController(*this),
 	m_VMController(*this),
 	m_RenderController(*this),
+	m_CellTuner("Cells", CellRunSize, MinCellRunSize, MaxCellRunSize),
+	m_LightTuner("Lights", LightRunSize, MinLightRunSize, MaxLightRunSize),
+	m_WasteTuner("Waste", WasteRunSize, MinWasteRunSize, MaxWasteRunSize),
 	m_HashName(init.m_HashName),
 	m_HashSeed(xtd::security::hash::fnv<uint64>(init.m_HashName))
 {
-	m_CellStore = new uint8[sizeof(Cell) * MaxNumCells];
-	m_NextFreeCell = &m_CellStore[0];
+	// Pages go to the node that first touches them, so with several nodes each one's store is allocated and its free
+	// list written by a task bound to it.
+	const uint32 nodeCount = uint32(Scheduler::get().node_count());
+	m_CellStores.resize(nodeCount);
+	const auto link_store = [this, nodeCount](uint32 node) {
+		CellStore &store = m_CellStores[node];
+		store.Capacity = (MaxNumCells + nodeCount - 1) / nodeCount;
+		store.Cells = new uint8[sizeof(Cell) * store.Capacity];
+		store.NextFree = &store.Cells[0];
+		for (uint i = 0; i < store.Capacity; ++i)
+		{
+			uptr *curCellPtr = (uptr *)&store.Cells[i * sizeof(Cell)];
 
-	for (uint i = 0; i < MaxNumCells; ++i)
+			*curCellPtr = uptr(&store.Cells[(i + 1) * sizeof(Cell)]);
+		}
+		*(uptr *)&store.Cells[(store.Capacity - 1) * sizeof(Cell)] = uptr(0);
+	};
+	if (nodeCount > 1)
 	{
-		uptr *curCellPtr = (uptr *)&m_CellStore[i * sizeof(Cell)];
+		TaskGraph graph;
+		for (uint32 node = 0; node < nodeCount; ++node)
+		{
+			graph.set_node(graph.add([&link_store, node] { link_store(node); }), node);
+		}
+		Scheduler::get().run_graph_on_nodes(graph);
+	}
+	else
+	{
+		link_store(0);
+	}
 
-		*curCellPtr = uptr(&m_CellStore[(i + 1) * sizeof(Cell)]);
+	// Each node works on a run of tiles along the Morton curve, sized by its workers, so its tiles are mostly each
+	// other's neighbours and the halos between nodes stay short.
+	{
+		const uint32 tileEdgeCount = m_PhysicsController.tile_edge_count();
+		m_TileNodes.resize(tileEdgeCount * tileEdgeCount, 0);
+		const usize workerCount = Scheduler::get().worker_count();
+		usize tile = 0;
+		usize workersSoFar = 0;
+		for (uint32 node = 0; node < nodeCount; ++node)
+		{
+			workersSoFar += Scheduler::get().node_worker_count(node);
+			const usize regionEnd = (m_TileNodes.size() * workersSoFar) / workerCount;
+			for (; tile < regionEnd; ++tile)
+			{
+				m_TileNodes[tile] = node;
+			}
+		}
 	}
-	*(uptr *)&m_CellStore[(MaxNumCells - 1) * sizeof(Cell)] = uptr(0);
 
 
 	// Initialize the store.
@@ -218,33 +324,23 @@ namespace phylo
 Simulation::~Simulation()
 {
 	g_pSimulation = nullptr;
-	delete[] m_CellStore;
+	for (CellStore &store : m_CellStores)
+	{
+		delete[] store.Cells;
+	}
 	m_NoisePipeline.freeCache(m_pNoiseCache);
 }
 
-void Simulation::pool_update() 
+void Simulation::pool_update(usize begin, usize end) 
 {
-	const uint numCells = m_Cells.size();
-
-	for (;;)
+	for (usize uIdx = begin; uIdx < end; ++uIdx)
 	{
-		static constexpr uint readAhead = 16;
-
-		uint uIdx = m_ThreadPoolIndex.fetch_add(readAhead);
-		uint finalIdx = std::min(uIdx + readAhead, numCells);
-		for (; uIdx < finalIdx; ++uIdx)
-		{
-			Cell *cell = m_Cells[uIdx];
-			cell->update();
-		}
-		if (finalIdx == numCells)
-		{
-			return;
-		}
+		Cell *cell = m_Cells[uIdx];
+		cell->update();
 	}
 }
 
-void Simulation::pool_update2() 
+void Simulation::pool_update2(usize begin, usize end) 
 {
 	// We alternate one row every frame because, well, it's really slow otherwise.
 
@@ -252,88 +348,50 @@ void Simulation::pool_update2()
 	const auto curProcessRow = m_CurProcessRow;
 	const bool flashlight = m_Flashlight;
 
-	static constexpr uint readAhead = 8;
-
-	for (;;)
+	for (uint uIdx = uint(begin); uIdx < uint(end); ++uIdx)
 	{
-		uint uIdx = m_ThreadPoolIndex.fetch_add(readAhead);
-		uint finalIdx = std::min(uIdx + readAhead, lightGridElementsEdge);
-		for (; uIdx < finalIdx; ++uIdx)
-		{
-			uint uIndex = uIdx + (lightGridElementsEdge * curProcessRow);
+		uint uIndex = uIdx + (lightGridElementsEdge * curProcessRow);
 
-			uint8 &intensity = m_LightGrid.m_GridElements[uIndex];
+		uint8 &intensity = m_LightGrid.m_GridElements[uIndex];
 
-			vector2F &position = m_LightGrid.m_GridElementsPositions[uIndex];
+		vector2F &position = m_LightGrid.m_GridElementsPositions[uIndex];
 
-			float value = clamp(float(m_NoiseSrc->getValue(position.x * MulFactor, position.y * MulFactor, m_LightmapZ, m_pNoiseCache) + 1.0f) * 0.5f, 0.0f, 1.0f);
-			value = sqrtf(value);
-			//value = value * value;
+		float value = clamp(float(m_NoiseSrc->getValue(position.x * MulFactor, position.y * MulFactor, m_LightmapZ, m_pNoiseCache) + 1.0f) * 0.5f, 0.0f, 1.0f);
+		value = sqrtf(value);
+		//value = value * value;
 
-			if (flashlight)
+		if (flashlight)
+		{
+			float distance = position.distance_sq(m_FlashlightPos);
+			const float flashlightDistanceSq = 10000.0f;
+			if (distance < 10000.0f)
 			{
-				float distance = position.distance_sq(m_FlashlightPos);
-				const float flashlightDistanceSq = 10000.0f;
-				if (distance < 10000.0f)
-				{
-					value += 1.0f - (distance / flashlightDistanceSq);
-					value = clamp(value, 0.0f, 1.0f);
-				}
+				value += 1.0f - (distance / flashlightDistanceSq);
+				value = clamp(value, 0.0f, 1.0f);
 			}
-
-			intensity = uint8(value * 255.5f);
-		}
-		if (finalIdx == lightGridElementsEdge)
-		{
-			return;
 		}
+
+		intensity = uint8(value * 255.5f);
 	}
 }
 
-void Simulation::pool_update_waste() 
+void Simulation::pool_update_waste(usize begin, usize end) 
 {
-	const auto numWasteGridElements = m_WasteGrid.m_GridElements.size();
-	const auto wasteGridElementsEdge = m_WasteGrid.m_GridElementsEdge;
-
-	for (;;)
+	for (usize uIdx = begin; uIdx < end; ++uIdx)
 	{
-		static constexpr uint readAhead = 64;
-
-		uint uIdx = m_ThreadPoolIndex.fetch_add(readAhead);
-		uint finalIdx = std::min(uIdx + readAhead, numWasteGridElements);
-		for (; uIdx < finalIdx; ++uIdx)
-		{
-			uint32 amount = m_WasteGrid.m_AtomicGridElements[uIdx];
-			amount = min(amount, m_WasteGrid.m_GridElements[uIdx]);
-			m_WasteGrid.m_GridElements[uIdx] -= amount;
-			m_WasteGrid.m_AtomicGridElements[uIdx] = 0;
-		}
-		if (finalIdx == numWasteGridElements)
-		{
-			return;
-		}
+		uint32 amount = m_WasteGrid.m_AtomicGridElements[uIdx];
+		amount = min(amount, m_WasteGrid.m_GridElements[uIdx]);
+		m_WasteGrid.m_GridElements[uIdx] -= amount;
+		m_WasteGrid.m_AtomicGridElements[uIdx] = 0;
 	}
 }
 
-void Simulation::pool_updatelite() 
+void Simulation::pool_updatelite(usize begin, usize end) 
 {
-	const uint numCells = m_Cells.size();
-
-	for (;;)
+	for (usize uIdx = begin; uIdx < end; ++uIdx)
 	{
-		static constexpr uint readAhead = 16;
-
-		uint uIdx = m_ThreadPoolIndex.fetch_add(readAhead);
-		uint finalIdx = std::min(uIdx + readAhead, numCells);
-		for (; uIdx < finalIdx; ++uIdx)
-		{
-			Cell *cell = m_Cells[uIdx];
-			cell->update_lite();
-		}
-		if (finalIdx == numCells)
-		{
-			return;
-		}
+		Cell *cell = m_Cells[uIdx];
+		cell->update_lite();
 	}
 }
 
@@ -398,6 +456,11 @@ public:
 		return *this;
 	}
 
+	clock::time_span last() const 
+	{
+		return clock::time_span(Times[(CurrentTimeOffset + elements - 1) % elements]);
+	}
+
 	string to_string() const 
 	{
 		int64 totalTime = 0;
@@ -458,7 +521,8 @@ void Simulation::spawn_initial_cell()
 		bestIndex = 0;
 	}
 
-	Cell *cell = getNewCellPtr();
+	// Its components do not exist yet to say what tile it is over, so it starts on the first node.
+	Cell *cell = getNewCellPtr(0);
 	new (cell) Cell(nullptr, *this, m_LightGrid.m_GridElementsPositions[bestIndex], true);
 	cell->m_CellIdx = cellIdx;
 	cell->setEnergy(cell->getObjectCapacity());
@@ -466,15 +530,21 @@ void Simulation::spawn_initial_cell()
 	++m_TotalCells;
 
 	// Move the camera to here.
-	m_pRenderer->set_screen_position(m_LightGrid.m_GridElementsPositions[bestIndex]);
+	if (m_pRenderer)
+	{
+		m_pRenderer->set_screen_position(m_LightGrid.m_GridElementsPositions[bestIndex]);
+	}
 }
 
 void Simulation::sim_loop() 
 {
 	m_KickoffEvent.join();
+	// This thread is worker 0 whenever it ticks.
+	Scheduler::get().pin_caller();
 
 	// This creates the first cell.
 	spawn_initial_cell();
+	calibrate_serial_policy();
 
 	clock::time_span tickTime = 0_msec; // This controls the speed of execution.
 
@@ -483,8 +553,283 @@ void Simulation::sim_loop()
 	uiData.NumCells = m_Cells.size();
 	uiData.CurTick = m_uCurrentFrame;
 
-	m_pRenderer->update_from_sim(m_Illumination, m_uCurrentFrame, m_RenderController.getRawData(), m_LightGrid.m_GridElements, m_LightGrid.m_GridElementsEdge, m_WasteGrid.m_GridElements, m_WasteGrid.m_GridElementsEdge, uiData, m_VMController.m_ExecutionCounter);
-	m_pRenderer->update_hash_name(m_HashName);
+	// Benchmarks run without a renderer.
+	if (m_pRenderer)
+	{
+		m_pRenderer->update_from_sim(m_Illumination, m_uCurrentFrame, m_RenderController.getRawData(), m_LightGrid.m_GridElements, m_LightGrid.m_GridElementsEdge, m_WasteGrid.m_GridElements, m_WasteGrid.m_GridElementsEdge, uiData, m_VMController.m_ExecutionCounter);
+		m_pRenderer->update_hash_name(m_HashName);
+	}
+
+	static AverageTime<50> totalTime;
+	static AverageTime<50> vmTime;
+	static AverageTime<50> physicsTime;
+	static AverageTime<50> renderTime;
+	static AverageTime<50> updateTime;
+	static AverageTime<50> postTime;
+	static AverageTime<50> lightTime;
+
+	// A tick, as a graph of its phases; each phase spreads itself over the workers. The VM and the cells read the
+	// light and waste grids, and post_update creates and destroys cells, so most of it is a chain. What does not
+	// depend on each other overlaps.
+	//
+	// The renderer is handed each tick's state while the next tick's VM and physics run. Nothing before the cells
+	// writes the render instances or the grids, so those are read in place; what the next tick does rewrite (the
+	// stats and the instruction counts) is copied aside at the end of the tick.
+	//
+	// The fused tick instead runs the VM, physics and cell phases a tile at a time, so a tile's cells are still in
+	// cache from one phase when the next gets to them. It keeps the phased tick's results: a tile's phase waits for
+	// the phase before it on every tile whose cells it can see (or whose cells can see it) to have run first.
+	struct RenderHandoff final
+	{
+		bool             Pending = false;
+		uint64           Frame = 0;
+		float            Illumination = 0.0f;
+		Renderer::UIData UIData;
+		decltype(m_VMController.m_ExecutionCounter) ExecutionCounter;
+	} handoff;
+
+	clock::time_point fusedTimeStart = clock::get_current_time();
+	// The lights and the waste overlap, so each keeps its own parallel time and the post task adds them in.
+	clock::time_span lightsParallelTime = clock::time_span(0ull);
+	clock::time_span wasteTime = clock::time_span(0ull);
+	const auto build_tick_graph = [&](TaskGraph &graph, bool fused) {
+		const TaskGraph::TaskID handoffTask = graph.add([&] {
+			clock::time_point thisTime = clock::get_current_time();
+			if (handoff.Pending && m_pRenderer && m_pRenderer->is_frame_ready())
+			{
+				m_pRenderer->update_from_sim(handoff.Illumination, handoff.Frame, m_RenderController.getRawData(), m_LightGrid.m_GridElements, m_LightGrid.m_GridElementsEdge, m_WasteGrid.m_GridElements, m_WasteGrid.m_GridElementsEdge, handoff.UIData, handoff.ExecutionCounter);
+			}
+			handoff.Pending = false;
+			// It overlaps other phases, so it counts as neither serial nor parallel time.
+			renderTime = clock::get_current_time() - thisTime;
+		});
+
+#if DYNAMIC_LIGHTS
+		// The lights and waste rewrite grids the handoff reads.
+		const TaskGraph::TaskID lightsTask = graph.add([&] {
+			clock::time_point thisTime = clock::get_current_time();
+			m_LightTuner.parallel_for(m_LightGrid.m_GridElementsEdge, [this](usize begin, usize end, usize) { pool_update2(begin, end); });
+			lightsParallelTime = clock::get_current_time() - thisTime;
+
+			clock::time_point subTime = clock::get_current_time();
+			++m_CurProcessRow;
+			m_CurProcessRow %= m_LightGrid.m_GridElementsEdge;
+			if (m_CurProcessRow == 0)
+			{
+				m_LightmapZ += options::LightMapChangeRate * float(m_LightGrid.m_GridElementsEdge);
+			}
+
+			double adjustedTick = double(m_uCurrentFrame) / (options::LightPeriodTicks / (xtd::pi<float>));
+			m_Illumination = sin((xtd::pi<float> / 2.0) * cos(adjustedTick));
+			m_Illumination = (m_Illumination + 1.0) / 2.0;
+
+			m_TotalSerialTime += clock::get_current_time() - subTime;
+			lightTime = clock::get_current_time() - thisTime;
+		}, { handoffTask });
+		// Waste decay touches nothing the lights do.
+		const TaskGraph::TaskID wasteTask = graph.add([&] {
+			clock::time_point thisTime = clock::get_current_time();
+			// TODO put into waste time
+			m_WasteTuner.parallel_for(m_WasteGrid.m_GridElements.size(), [this](usize begin, usize end, usize) { pool_update_waste(begin, end); });
+			wasteTime = clock::get_current_time() - thisTime;
+		}, { handoffTask });
+#endif
+		// Adds a task that runs once the light and waste grids are up to date.
+		const auto add_after_grids = [&](function<void()> &&fn) -> TaskGraph::TaskID {
+#if DYNAMIC_LIGHTS
+			return graph.add(std::move(fn), { lightsTask, wasteTask });
+#else
+			return graph.add(std::move(fn));
+#endif
+		};
+
+		TaskGraph::TaskID vmTask;
+		TaskGraph::TaskID cellsTask;
+		// The VM and physics controllers add their own serial and parallel time in the phased tick.
+		if (!fused)
+		{
+			vmTask = add_after_grids([&] {
+				clock::time_point thisTime = clock::get_current_time();
+				m_VMController.update();
+				vmTime = clock::get_current_time() - thisTime;
+			});
+			const TaskGraph::TaskID physicsTask = graph.add([&] {
+				clock::time_point thisTime = clock::get_current_time();
+				m_PhysicsController.update();
+				physicsTime = clock::get_current_time() - thisTime;
+
+				m_RenderController.update();
+			}, { vmTask });
+			cellsTask = graph.add([&] {
+				clock::time_point thisTime = clock::get_current_time();
+				// Update the cells (copies data between components)
+				m_CellTuner.parallel_for(m_Cells.size(), [this](usize begin, usize end, usize) { pool_update(begin, end); });
+				m_TotalParallelTime += clock::get_current_time() - thisTime;
+				updateTime = clock::get_current_time() - thisTime;
+			}, { physicsTask, handoffTask });
+		}
+		else
+		{
+			const TaskGraph::TaskID beginTask = add_after_grids([&] {
+				clock::time_point thisTime = clock::get_current_time();
+				m_VMController.begin_update();
+				m_PhysicsController.begin_tiles();
+				fusedTimeStart = clock::get_current_time();
+				m_TotalSerialTime += fusedTimeStart - thisTime;
+			});
+
+			const uint32 tileEdgeCount = m_PhysicsController.tile_edge_count();
+			array<TaskGraph::TaskID> vmTasks;
+			array<TaskGraph::TaskID> integrateTasks;
+			array<TaskGraph::TaskID> collideTasks;
+			array<TaskGraph::TaskID> cellTasks;
+			vmTasks.resize(tileEdgeCount * tileEdgeCount);
+			integrateTasks.resize(tileEdgeCount * tileEdgeCount);
+			collideTasks.resize(tileEdgeCount * tileEdgeCount);
+			cellTasks.resize(tileEdgeCount * tileEdgeCount);
+
+			// Adds a task for every tile, each waiting on the previous stage's tasks within 'halo' tiles of it.
+			const auto add_stage = [&](array<TaskGraph::TaskID> &stage, const array<TaskGraph::TaskID> *previous, uint32 halo, auto make_task) {
+				for (uint32 y = 0; y < tileEdgeCount; ++y)
+				{
+					for (uint32 x = 0; x < tileEdgeCount; ++x)
+					{
+						const uint32 tile = m_PhysicsController.tile_index(x, y);
+						stage[tile] = graph.add(make_task(tile));
+						graph.set_node(stage[tile], m_TileNodes[tile]);
+						if (!previous)
+						{
+							graph.add_dependency(stage[tile], beginTask);
+							continue;
+						}
+
+						const uint32 minX = (x > halo) ? (x - halo) : 0;
+						const uint32 minY = (y > halo) ? (y - halo) : 0;
+						const uint32 maxX = min(x + halo, tileEdgeCount - 1);
+						const uint32 maxY = min(y + halo, tileEdgeCount - 1);
+						for (uint32 haloY = minY; haloY <= maxY; ++haloY)
+						{
+							for (uint32 haloX = minX; haloX <= maxX; ++haloX)
+							{
+								graph.add_dependency(stage[tile], (*previous)[m_PhysicsController.tile_index(haloX, haloY)]);
+							}
+						}
+					}
+				}
+			};
+
+			// The VM reads the shadow state of the cells around it and finds them through the grid, both of which
+			// integration rewrites.
+			add_stage(vmTasks, nullptr, 0, [this](uint32 tile) -> function<void()> {
+				return [this, tile] {
+					m_PhysicsController.gather_tile(tile);
+					for (Physics::Instance *instance : m_PhysicsController.tile_instances(tile))
+					{
+						m_VMController.update_instance(*instance->m_Cell->m_VMInstance);
+					}
+				};
+			});
+			add_stage(integrateTasks, &vmTasks, 1, [this](uint32 tile) -> function<void()> {
+				return [this, tile] { m_PhysicsController.integrate_tile(tile); };
+			});
+			// Collisions read where the cells around them ended up. A neighbour's cells may have come from the
+			// tile past it, so this waits two tiles out; the same goes for the cells, which resize what collisions read.
+			add_stage(collideTasks, &integrateTasks, 2, [this](uint32 tile) -> function<void()> {
+				return [this, tile] { m_PhysicsController.collide_tile(tile); };
+			});
+			add_stage(cellTasks, &collideTasks, 2, [this](uint32 tile) -> function<void()> {
+				return [this, tile] {
+					for (Physics::Instance *instance : m_PhysicsController.tile_instances(tile))
+					{
+						instance->m_Cell->update();
+					}
+				};
+			});
+			for (TaskGraph::TaskID task : cellTasks)
+			{
+				graph.add_dependency(task, handoffTask);
+			}
+
+			vmTask = graph.add([] {});
+			for (TaskGraph::TaskID task : vmTasks)
+			{
+				graph.add_dependency(vmTask, task);
+			}
+			cellsTask = graph.add([&] {
+				// The phases overlap, so they are only timed as a whole, from the tiles' start to the last one's end.
+				clock::time_point thisTime = clock::get_current_time();
+				const clock::time_span fusedTime = thisTime - fusedTimeStart;
+				m_TotalParallelTime += fusedTime;
+				vmTime = clock::time_span(0ull);
+				physicsTime = clock::time_span(0ull);
+				updateTime = fusedTime;
+
+				m_VMController.end_update();
+				m_RenderController.update();
+				m_TotalSerialTime += clock::get_current_time() - thisTime;
+			});
+			for (TaskGraph::TaskID task : cellTasks)
+			{
+				graph.add_dependency(cellsTask, task);
+			}
+		}
+
+		// The population only changes in post_update, and the genome, arena and native code statistics are counters
+		// that are safe to read at any time, so these are gathered while physics and the cells run. Cells mutating
+		// meanwhile only shift the display by a tick.
+		const TaskGraph::TaskID statsTask = graph.add([&] {
+			uiData.NumCells = m_Cells.size();
+			uiData.CurTick = m_uCurrentFrame;
+			uiData.TotalCells = m_TotalCells.load();
+			uiData.UniqueGenomes = VM::GenomeStore::get().unique_count();
+			const auto genomeAnalysis = VM::GenomeStore::get().get_statistics();
+			uiData.GenomeSlots = genomeAnalysis.CodeSlots;
+			uiData.ReachableSlots = genomeAnalysis.ReachableSlots;
+			uiData.PassiveGenomes = genomeAnalysis.PassiveGenomes;
+			const auto genomeMemory = VM::GenomeArena::get_statistics();
+			uiData.GenomeBytesLive = genomeMemory.BytesLive;
+			uiData.GenomeBytesReserved = genomeMemory.BytesReserved;
+			const auto nativeCode = VM::JitCode::get_statistics();
+			uiData.NativeGenomes = nativeCode.Genomes;
+			uiData.NativeCodeBytes = nativeCode.CodeBytes;
+			uiData.NativeMismatches = nativeCode.Mismatches;
+		}, { vmTask });
+		graph.add([&, fused] {
+			clock::time_point thisTime = clock::get_current_time();
+			m_VMController.post_update();
+
+			clock::time_point subTime = clock::get_current_time();
+			if (m_DestroyTasks.size())
+			{
+				if (options::Deterministic)
+				{
+					std::sort(m_DestroyTasks.data(), m_DestroyTasks.data() + m_DestroyTasks.size(), [](const Cell * a, const Cell * b) { return a->getCellID() < b->getCellID(); });
+				}
+				for (Cell *cell : m_DestroyTasks)
+				{
+					destroyCell(*cell);
+				}
+				m_DestroyTasks.clear();
+			}
+			if ((m_uCurrentFrame % ArenaTrimTicks) == 0)
+			{
+				VM::GenomeArena::trim();
+			}
+			// Only the fused tick works on tiles by node, so only it keeps the cells in their node's store.
+			if (fused)
+			{
+				rehome_cells();
+			}
+			m_TotalSerialTime += clock::get_current_time() - subTime;
+			m_TotalParallelTime += lightsParallelTime + wasteTime;
+			postTime = clock::get_current_time() - thisTime;
+		}, { cellsTask, statsTask });
+	};
+
+	TaskGraph tickGraph;
+	TaskGraph fusedTickGraph;
+	build_tick_graph(tickGraph, false);
+	build_tick_graph(fusedTickGraph, true);
 
 	clock::time_point lastExecuteTime = clock::get_current_time();
 	while (m_SimThreadRun)
@@ -543,12 +888,16 @@ void Simulation::sim_loop()
 
 		if (((sinceLastTime < tickTime) | (m_SpeedState == SpeedState::Pause)) & (!m_Step))
 		{
-			m_ThreadPoolIndex = 0ull;
-			m_ThreadPool3.kickoff();
+			Scheduler::get().parallel_for(m_Cells.size(), CellRunSize, [this](usize begin, usize end, usize) { pool_updatelite(begin, end); });
+			// This hands over the current state, which is newer than the last tick's.
+			handoff.Pending = false;
 			// HACK
-			m_pRenderer->update_from_sim(m_Illumination, m_uCurrentFrame, m_RenderController.getRawData(), m_LightGrid.m_GridElements, m_LightGrid.m_GridElementsEdge, m_WasteGrid.m_GridElements, m_WasteGrid.m_GridElementsEdge, uiData, m_VMController.m_ExecutionCounter);
-			m_pRenderer->update_from_sim(uiData);
-			m_pRenderer->force_update();
+			if (m_pRenderer)
+			{
+				m_pRenderer->update_from_sim(m_Illumination, m_uCurrentFrame, m_RenderController.getRawData(), m_LightGrid.m_GridElements, m_LightGrid.m_GridElementsEdge, m_WasteGrid.m_GridElements, m_WasteGrid.m_GridElementsEdge, uiData, m_VMController.m_ExecutionCounter);
+				m_pRenderer->update_from_sim(uiData);
+				m_pRenderer->force_update();
+			}
 			system::yield();
 			continue;
 		}
@@ -594,112 +943,22 @@ void Simulation::sim_loop()
 				spawn_initial_cell();
 			}
 
-			static AverageTime<50> totalTime;
-			static AverageTime<50> vmTime;
-			static AverageTime<50> physicsTime;
-			static AverageTime<50> renderTime;
-			static AverageTime<50> updateTime;
-			static AverageTime<50> postTime;
-			static AverageTime<50> lightTime;
-
 			clock::time_point totalTimeStart = clock::get_current_time();
+			Scheduler::get().set_serial(m_SerialTicks);
+			const uint64 dispatchesBefore = Scheduler::get().dispatch_count();
+			Scheduler::get().run_graph(options::FusedTick ? fusedTickGraph : tickGraph);
+			m_TickDispatches = Scheduler::get().dispatch_count() - dispatchesBefore;
 
-#if DYNAMIC_LIGHTS
-			{
-				clock::time_point thisTime = clock::get_current_time();
-				clock::time_point subTime = thisTime;
-				m_ThreadPoolIndex = 0ull;
-				m_ThreadPool2.kickoff();
-				++m_CurProcessRow;
-				m_CurProcessRow %= m_LightGrid.m_GridElementsEdge;
-				if (m_CurProcessRow == 0)
-				{
-					m_LightmapZ += options::LightMapChangeRate * float(m_LightGrid.m_GridElementsEdge);
-				}
-				m_TotalSerialTime += clock::get_current_time() - subTime;
-
-				subTime = clock::get_current_time();
-				// TODO put into waste time
-				m_ThreadPoolIndex = 0ull;
-				m_ThreadPool4.kickoff();
-				m_TotalParallelTime += clock::get_current_time() - subTime;
-
-				subTime = clock::get_current_time();
-				double adjustedTick = double(m_uCurrentFrame) / (options::LightPeriodTicks / (xtd::pi<float>));
-				m_Illumination = sin((xtd::pi<float> / 2.0) * cos(adjustedTick));
-				m_Illumination = (m_Illumination + 1.0) / 2.0;
-
-				m_TotalSerialTime += clock::get_current_time() - subTime;
-				lightTime = clock::get_current_time() - thisTime;
-			}
-#endif
-
-			{
-				clock::time_point thisTime = clock::get_current_time();
-				m_VMController.update();
-				vmTime = clock::get_current_time() - thisTime;
-			}
-			{
-				clock::time_point thisTime = clock::get_current_time();
-				m_PhysicsController.update();
-				physicsTime = clock::get_current_time() - thisTime;
-			}
-
-			m_RenderController.update();
-
-			{
-				clock::time_point thisTime = clock::get_current_time();
-				// Update the cells (copies data between components)
-				m_ThreadPoolIndex = 0ull;
-				m_ThreadPool.kickoff();
-				m_TotalParallelTime += clock::get_current_time() - thisTime;
-				updateTime = clock::get_current_time() - thisTime;
-			}
-
-			bool renderUpdate = false;
-			{
-				clock::time_point thisTime = clock::get_current_time();
-				uiData.NumCells = m_Cells.size();
-				uiData.CurTick = m_uCurrentFrame;
-				uiData.TotalCells = m_TotalCells.load();
-				if (m_pRenderer && m_pRenderer->is_frame_ready())
-				{
-					m_pRenderer->update_from_sim(m_Illumination, m_uCurrentFrame, m_RenderController.getRawData(), m_LightGrid.m_GridElements, m_LightGrid.m_GridElementsEdge, m_WasteGrid.m_GridElements, m_WasteGrid.m_GridElementsEdge, uiData, m_VMController.m_ExecutionCounter);
-					renderUpdate = true;
-				}
-				m_TotalSerialTime += clock::get_current_time() - thisTime;
-				renderTime = clock::get_current_time() - thisTime;
-			}
-
-			{
-				clock::time_point thisTime = clock::get_current_time();
-				m_VMController.post_update();
-
-				clock::time_point subTime = clock::get_current_time();
-				if (m_DestroyTasks.size())
-				{
-					if (options::Deterministic)
-					{
-						std::sort(m_DestroyTasks.data(), m_DestroyTasks.data() + m_DestroyTasks.size(), [](const Cell * a, const Cell * b) { return a->getCellID() < b->getCellID(); });
-					}
-					for (Cell *cell : m_DestroyTasks)
-					{
-						destroyCell(*cell);
-					}
-					m_DestroyTasks.clear();
-				}
-				m_TotalSerialTime += clock::get_current_time() - subTime;
-				postTime = clock::get_current_time() - thisTime;
-			}
-
-			totalTime = clock::get_current_time() - totalTimeStart;
+			const clock::time_span tickSpan = clock::get_current_time() - totalTimeStart;
+			totalTime = tickSpan;
+			update_serial_policy(tickSpan);
 
 			//if (m_uCurrentFrame == 200000)
 			//{
 			//	m_SpeedState = SpeedState::Pause;
 			//}
 
-			if ((m_LoadedFrame != m_uCurrentFrame) & ((m_uCurrentFrame % 200000) == 0))
+			if ((m_LoadedFrame != m_uCurrentFrame) & ((m_uCurrentFrame % 200000) == 0) & (m_TickLimit == 0))
 			{
 				Autosave();
 			}
@@ -716,15 +975,124 @@ void Simulation::sim_loop()
 			uiData.lightTime = lightTime;
 			uiData.serialTime = m_TotalSerialTime;
 			uiData.parallelTime = m_TotalParallelTime;
+
+			// Read here rather than in the stats task, as the tuners change them while their phases run.
+			const auto get_tuning = [](const PhaseTuner &tuner) -> Renderer::UIData::PhaseTuning {
+				return { uint32(tuner.parameters().Grain), uint32(tuner.parameters().Workers) };
+			};
+			uiData.VMTuning = get_tuning(m_VMController.tuner());
+			uiData.IntegrateTuning = get_tuning(m_PhysicsController.integrate_tuner());
+			uiData.CollideTuning = get_tuning(m_PhysicsController.collide_tuner());
+			uiData.CellTuning = get_tuning(m_CellTuner);
+
+			// For the next tick's handoff.
+			handoff.Pending = true;
+			handoff.Frame = uiData.CurTick;
+			handoff.Illumination = m_Illumination;
+			handoff.UIData = uiData;
+			for (usize i = 0; i < handoff.ExecutionCounter.size(); ++i)
+			{
+				handoff.ExecutionCounter[i] = m_VMController.m_ExecutionCounter[i].load();
+			}
+
+			if (m_TickLimit != 0)
+			{
+				if (++m_TicksRun > m_WarmupTicks)
+				{
+					++m_RunTotals.Ticks;
+					m_RunTotals.CellTicks += m_Cells.size();
+					m_RunTotals.Total += tickSpan;
+					m_RunTotals.VM += vmTime.last();
+					m_RunTotals.Physics += physicsTime.last();
+					m_RunTotals.CellUpdate += updateTime.last();
+					m_RunTotals.RenderCopy += renderTime.last();
+					m_RunTotals.Post += postTime.last();
+					m_RunTotals.Light += lightTime.last();
+					m_RunTotals.Serial += m_TotalSerialTime;
+					m_RunTotals.Parallel += m_TotalParallelTime;
+				}
+				if (m_TicksRun == (m_WarmupTicks + m_TickLimit))
+				{
+					m_RunTotals.VMTuning = uiData.VMTuning;
+					m_RunTotals.IntegrateTuning = uiData.IntegrateTuning;
+					m_RunTotals.CollideTuning = uiData.CollideTuning;
+					m_RunTotals.CellTuning = uiData.CellTuning;
+					m_SimThreadRun = false;
+					m_RunFinished.set();
+				}
+			}
 		}
 		lastExecuteTime = thisTime;
 	}
 }
 
+void Simulation::calibrate_serial_policy() 
+{
+	static constexpr uint CalibrationPhases = 1000;
+
+	m_DispatchNanoseconds = Scheduler::get().measure_dispatch(CalibrationPhases).Median * 1000.0;
+	m_CellNanoseconds = 0.0;
+	m_SerialTicks = true;
+}
+
+void Simulation::update_serial_policy(clock::time_span tickTime) 
+{
+	const uint numCells = m_Cells.size();
+	const usize numWorkers = Scheduler::get().active_worker_count();
+	if (numWorkers == 1)
+	{
+		m_SerialTicks = true;
+		return;
+	}
+
+	if (numCells >= MinSerialSampleCells)
+	{
+		// A parallel tick stands in for a serial one as its time less the dispatches, spread back over the workers.
+		// That takes the phases to scale perfectly, so it reads high, which only keeps the tick parallel for longer
+		// than it strictly should; it is what keeps the estimate current while the population is too large to tick
+		// serially at all.
+		const double tickNanoseconds = double(int64(tickTime));
+		const double serialNanoseconds = m_SerialTicks ?
+			tickNanoseconds :
+			(max(tickNanoseconds - (double(m_TickDispatches) * m_DispatchNanoseconds), 0.0) * double(numWorkers));
+		const double cellNanoseconds = serialNanoseconds / double(numCells);
+		m_CellNanoseconds = (m_CellNanoseconds == 0.0) ? cellNanoseconds : (m_CellNanoseconds + ((cellNanoseconds - m_CellNanoseconds) / 16.0));
+	}
+
+	uint threshold;
+	if (options::SerialCellThreshold > 0)
+	{
+		threshold = uint(options::SerialCellThreshold);
+	}
+	else if (m_CellNanoseconds == 0.0)
+	{
+		// Nothing measured yet; stay serial until something is.
+		threshold = traits<uint>::max / 2;
+	}
+	else
+	{
+		// Spread over n workers, a tick saves (1 - 1/n) of its serial cost and pays for the dispatches it makes.
+		const double savedPerCell = m_CellNanoseconds * (1.0 - (1.0 / double(numWorkers)));
+		threshold = uint(min((double(m_TickDispatches) * m_DispatchNanoseconds) / savedPerCell, double(traits<uint>::max / 2)));
+	}
+
+	// A quarter either side, so a population hovering at the threshold does not flip every tick.
+	const uint margin = threshold / 4;
+	if (m_SerialTicks)
+	{
+		m_SerialTicks = (numCells <= (threshold + margin));
+	}
+	else
+	{
+		m_SerialTicks = (numCells < (threshold - margin));
+	}
+}
+
 Cell &Simulation::getNewCell(const Cell *parent) 
 {
 	uint cellIdx = m_Cells.size();
-	Cell *cell = getNewCellPtr();
+	// It has no position yet, so it starts on the first node; rehome_cells() moves it once it has one.
+	Cell *cell = getNewCellPtr(0);
 	new (cell) Cell(parent, *this, vector2F());
 	cell->m_CellIdx = cellIdx;
 	cell->setEnergy(cell->getObjectCapacity());
@@ -734,6 +1102,20 @@ Cell &Simulation::getNewCell(const Cell *parent)
 	return *cell;
 }
 
+Cell &Simulation::getNewCell(const random::source<random::engine::xorshift_plus> &random, usize cellID, const Cell &parent) 
+{
+	uint cellIdx = m_Cells.size();
+	// Children are born next to their parent, so they start out in the store of the node the parent's tile is on.
+	Cell *cell = getNewCellPtr(home_node(parent));
+	new (cell) Cell(random, cellID, *this, vector2F());
+	cell->m_CellIdx = cellIdx;
+	cell->setEnergy(cell->getObjectCapacity());
+	m_Cells += cell;
+	++m_TotalCells;
+
+	return *cell;
+}
+
 void Simulation::killCell(Cell &cell) 
 {
 	cell.m_Alive = false;
@@ -923,6 +1305,99 @@ struct scoped_decrement
 	~scoped_decrement() { --value; }
 };
 
+Simulation *Simulation::load(const string &path, event &startProcessing, event &waitThreadProcessing) 
+{
+	Simulation *newSimulation = nullptr;
+	decltype(m_WasteGrid.m_GridElements) newWasteGrid;
+
+	try
+	{
+		io::file inFile(path, io::file::Flags::Sequential | io::file::Flags::Read);
+		array_view<uint8> view = { (uint8 * )inFile.at(0), inFile.get_size() };
+		Stream inStream(view);
+
+		uint32 compressed;
+		uint64 uncompressedSize;
+
+		inStream.read(compressed);
+		inStream.read(uncompressedSize);
+
+		loadInitializer loadInit;
+		xtd::array<Cell *>::size_type numCells;
+
+		auto unserialize = [&](Stream &inStream)
+		{
+			options_delta curOptions;
+			inStream.read(curOptions);
+			curOptions.apply();
+
+			loadInit.m_HashName = inStream.readString();
+			uint64 totalCells = 0;
+			inStream.read<uint64>(totalCells);
+			inStream.read(loadInit.m_uCurrentFrame);
+			inStream.read(loadInit.m_SimGridElementsEdge);
+			inStream.read(loadInit.m_LightGridElementsEdge);
+			inStream.read(loadInit.m_WasteGridElementsEdge);
+			inStream.read(loadInit.m_LightmapZ);
+			inStream.read(loadInit.m_CurProcessRow);
+			inStream.read(loadInit.m_NoiseSeed); // This isn't the current adjusted seed.
+			decltype(m_WasteGrid.m_GridElements.size()) elementCount;
+			inStream.read(elementCount);
+			newWasteGrid.resize(elementCount);
+			for (size_t i = 0; i < elementCount; ++i)
+			{
+				inStream.read(newWasteGrid[i]);
+			}
+			inStream.read(numCells);
+
+			// new Simulation
+			newSimulation = new Simulation(startProcessing, waitThreadProcessing, loadInit);
+			newSimulation->m_WasteGrid.m_GridElements = std::move(newWasteGrid);
+			for (xtd::array<Cell * >::size_type i = 0; i < numCells; ++i)
+			{
+				Cell &newCell = newSimulation->getNewCell(nullptr);
+				newCell.unserialize(inStream);
+			}
+			newSimulation->m_TotalCells = totalCells;
+		};
+
+		if (compressed)
+		{
+			array<uint8> uncompressedData(uncompressedSize);
+			compression::bulk_decompress<compression::zlib>(
+			{ (uint8 * )inFile.at(sizeof(uint32) + sizeof(uint64)), inFile.get_size() - (sizeof(uint32) + sizeof(uint64))
+			}, uncompressedData);
+
+			//compression::streaming_store StreamStore(0x4000, 32);
+			//
+			//array_view<uint8> compressedView = { inStream.getRawData().data() + sizeof(uint32) + sizeof(uint64), inStream.getRawData().size_raw() - (sizeof(uint32) + sizeof(uint64)) };
+			//
+			//compression::stream<compression::zlib> compressStream(compressedView);
+			//
+			//compression::streaming_array streamArray(StreamStore, compressStream, uncompressedSize);
+			//
+			//array_view<uint8> uncompressedView = { (uint8 *)streamArray.get_ptr(), uncompressedSize };
+			//Stream uncompressedStream(uncompressedView);
+
+			//unserialize(uncompressedStream);
+			array_view<uint8> uncompressedView = { (uint8 * )uncompressedData.data(), uncompressedData.size_raw() };
+			Stream uncompressedStream(uncompressedView);
+			unserialize(uncompressedStream);
+		}
+		else
+		{
+			unserialize(inStream);
+		}
+	}
+	catch (...)
+	{
+		delete newSimulation;
+		throw "Unable to load";
+	}
+
+	return newSimulation;
+}
+
 void Simulation::onLoad() 
 {
 	event startNewSimulation;
@@ -984,8 +1459,6 @@ void Simulation::onLoad()
 		extern void ResetWorkingDirectory();
 		ResetWorkingDirectory();
 
-		decltype(m_WasteGrid.m_GridElements) newWasteGrid;
-
 		if (!bOpen)
 		{
 			// Determine if they cancelled or it was an error.
@@ -1005,95 +1478,9 @@ void Simulation::onLoad()
 			return;
 		}
 
-		{
-			// Read in the file.
-			try
-			{
-				io::file inFile(string{ path }, io::file::Flags::Sequential | io::file::Flags::Read);
-				array_view<uint8> view = { (uint8 * )inFile.at(0), inFile.get_size() };
-				Stream inStream(view);
-
-				uint32 compressed;
-				uint64 uncompressedSize;
-
-				inStream.read(compressed);
-				inStream.read(uncompressedSize);
-
-				loadInitializer loadInit;
-				xtd::array<Cell *>::size_type numCells;
-
-				auto unserialize = [&](Stream &inStream)
-				{
-					options_delta curOptions;
-					inStream.read(curOptions);
-					curOptions.apply();
-
-					loadInit.m_HashName = inStream.readString();
-					uint64 totalCells = 0;
-					inStream.read<uint64>(totalCells);
-					inStream.read(loadInit.m_uCurrentFrame);
-					inStream.read(loadInit.m_SimGridElementsEdge);
-					inStream.read(loadInit.m_LightGridElementsEdge);
-					inStream.read(loadInit.m_WasteGridElementsEdge);
-					inStream.read(loadInit.m_LightmapZ);
-					inStream.read(loadInit.m_CurProcessRow);
-					inStream.read(loadInit.m_NoiseSeed); // This isn't the current adjusted seed.
-					decltype(m_WasteGrid.m_GridElements.size()) elementCount;
-					inStream.read(elementCount);
-					newWasteGrid.resize(elementCount);
-					for (size_t i = 0; i < elementCount; ++i)
-					{
-						inStream.read(newWasteGrid[i]);
-					}
-					inStream.read(numCells);
-
-					// new Simulation
-					newSimulation = new Simulation(startNewSimulation, threadKickedOff, loadInit);
-					newSimulation->m_WasteGrid.m_GridElements = std::move(newWasteGrid);
-					for (xtd::array<Cell * >::size_type i = 0; i < numCells; ++i)
-					{
-						Cell &newCell = newSimulation->getNewCell(nullptr);
-						newCell.unserialize(inStream);
-					}
-					newSimulation->m_TotalCells = totalCells;
-				};
-
-				if (compressed)
-				{
-					array<uint8> uncompressedData(uncompressedSize);
-					compression::bulk_decompress<compression::zlib>(
-					{ (uint8 * )inFile.at(sizeof(uint32) + sizeof(uint64)), inFile.get_size() - (sizeof(uint32) + sizeof(uint64))
-					}, uncompressedData);
-
-					//compression::streaming_store StreamStore(0x4000, 32);
-					//
-					//array_view<uint8> compressedView = { inStream.getRawData().data() + sizeof(uint32) + sizeof(uint64), inStream.getRawData().size_raw() - (sizeof(uint32) + sizeof(uint64)) };
-					//
-					//compression::stream<compression::zlib> compressStream(compressedView);
-					//
-					//compression::streaming_array streamArray(StreamStore, compressStream, uncompressedSize);
-					//
-					//array_view<uint8> uncompressedView = { (uint8 *)streamArray.get_ptr(), uncompressedSize };
-					//Stream uncompressedStream(uncompressedView);
-
-					//unserialize(uncompressedStream);
-					array_view<uint8> uncompressedView = { (uint8 * )uncompressedData.data(), uncompressedData.size_raw() };
-					Stream uncompressedStream(uncompressedView);
-					unserialize(uncompressedStream);
-				}
-				else
-				{
-					unserialize(inStream);
-				}
-			}
-			catch (...)
-			{
-				delete newSimulation;
-				throw "Unable to load";
-			}
+		newSimulation = load(string{ path }, startNewSimulation, threadKickedOff);
+		m_SimThreadRun = false;
 
-			m_SimThreadRun = false;
-		}
 		newSimulation->m_SpeedState = m_SpeedState;
 
 		newSimulation->set_renderer(phylo::g_pRenderer);
@@ -30,12 +30,6 @@ namespace phylo
    private:
       uint64         m_uCurrentFrame = 1ull;
 
-      ThreadPool                 m_ThreadPool;
-      ThreadPool                 m_ThreadPool2;
-      ThreadPool                 m_ThreadPool3;
-      ThreadPool                 m_ThreadPool4;
-      atomic<uint>              m_ThreadPoolIndex;
-
       thread         m_SimThread;
       atomic<bool>   m_SimThreadRun = true;
 
@@ -64,6 +58,11 @@ namespace phylo
       VM::Controller             m_VMController;
       Render::Controller         m_RenderController;
 
+      // The simulation's own phases; the VM and physics controllers tune theirs.
+      PhaseTuner                 m_CellTuner;
+      PhaseTuner                 m_LightTuner;
+      PhaseTuner                 m_WasteTuner;
+
    public:
 	  clock::time_span m_TotalParallelTime;
 	  clock::time_span m_TotalSerialTime;
@@ -127,16 +126,67 @@ namespace phylo
 	  float					   m_Illumination = 0.0f;
 
       static constexpr uint MaxNumCells = 100000;
-      uint8                   *m_NextFreeCell = nullptr;
-      uint8                   *m_CellStore = nullptr;
+      // The cells are kept in a store per NUMA node the scheduler places work on (just the one otherwise), between
+      // them holding MaxNumCells. Each is first touched, and so placed, by its node's workers, and holds the cells over
+      // the tiles that node works on in the fused tick.
+      struct CellStore final
+      {
+         uint8                *Cells = nullptr;
+         uint8                *NextFree = nullptr; // Each free cell starts with a pointer to the next.
+         uint                 Capacity = 0;
+      };
+      array<CellStore>        m_CellStores;
+      array<uint32>           m_TileNodes;   // The node that works on each tile in the fused tick.
 
-      void pool_update() ;
-      void pool_update2() ;
-      void pool_update_waste() ;
-      void pool_updatelite() ;
+      void pool_update(usize begin, usize end) ;
+      void pool_update2(usize begin, usize end) ;
+      void pool_update_waste(usize begin, usize end) ;
+      void pool_updatelite(usize begin, usize end) ;
 
       void spawn_initial_cell() ;
 
+      // Small populations tick on the sim thread alone: waking the workers for each phase costs more than the
+      // phases. The crossover is where a serial tick's per-cell cost, spread over the workers, saves more than the
+      // dispatches cost, unless options::SerialCellThreshold fixes it.
+      static constexpr uint MinSerialSampleCells = 32;  // Smaller populations are too noisy to time.
+      double         m_DispatchNanoseconds = 0.0;       // Median round trip of an empty phase, measured at startup.
+      double         m_CellNanoseconds = 0.0;           // Running average of a serial tick's cost per cell.
+      uint64         m_TickDispatches = 0;              // Dispatches the last tick made, serial or not.
+      bool           m_SerialTicks = true;
+
+      void calibrate_serial_policy() ;
+      void update_serial_policy(clock::time_span tickTime) ;
+
+   public:
+      // What a run with a tick limit measured, summed over its ticks after the warm-up. Phases overlap in the tick's
+      // graph, so they need not add up to the total.
+      struct RunTotals
+      {
+         uint64           Ticks = 0;
+         uint64           CellTicks = 0;  // The population, summed over the ticks.
+         clock::time_span Total = clock::time_span(0ull);
+         clock::time_span VM = clock::time_span(0ull);
+         clock::time_span Physics = clock::time_span(0ull);
+         clock::time_span CellUpdate = clock::time_span(0ull);
+         clock::time_span RenderCopy = clock::time_span(0ull);
+         clock::time_span Post = clock::time_span(0ull);
+         clock::time_span Light = clock::time_span(0ull);
+         clock::time_span Serial = clock::time_span(0ull);
+         clock::time_span Parallel = clock::time_span(0ull);
+         // As the run ended.
+         Renderer::UIData::PhaseTuning VMTuning;
+         Renderer::UIData::PhaseTuning IntegrateTuning;
+         Renderer::UIData::PhaseTuning CollideTuning;
+         Renderer::UIData::PhaseTuning CellTuning;
+      };
+
+   private:
+      uint64         m_WarmupTicks = 0;
+      uint64         m_TickLimit = 0;  // 0 runs until halted.
+      uint64         m_TicksRun = 0;
+      RunTotals      m_RunTotals;
+      event          m_RunFinished;
+
       SpeedState m_SpeedState = SpeedState::Ludicrous;
       bool m_Step = false;
 
@@ -168,6 +218,23 @@ namespace phylo
       Simulation(const string &hashName);
       virtual ~Simulation() override;
 
+      // Reads a saved simulation, applying the options it was saved with. Throws if the file cannot be read.
+      static Simulation *load(const string &path, event &startProcessing, event &waitThreadProcessing);
+
+      // Makes the sim thread stop by itself after 'ticks' ticks past 'warmupTicks', timing them; must come before
+      // kickoff(). wait_for_run() returns once they have run.
+      void set_tick_limit(uint64 warmupTicks, uint64 ticks)
+      {
+         m_WarmupTicks = warmupTicks;
+         m_TickLimit = ticks;
+      }
+
+      const RunTotals &wait_for_run()
+      {
+         m_RunFinished.join();
+         return m_RunTotals;
+      }
+
       uint64 get_hash_seed()  const { return m_HashSeed; }
 
       bool is_saving()  const { return m_Saving != 0; }
@@ -235,6 +302,7 @@ namespace phylo
 
       // Internal Public functions
       Cell &getNewCell(const Cell *parent) ;
+      Cell &getNewCell(const random::source<random::engine::xorshift_plus> &random, usize cellID, const Cell &parent) ;
       void killCell(Cell &cell) ;
       void beEatenCell(Cell &cell) ;
       void destroyCell(Cell &cell) ;
@@ -242,8 +310,11 @@ namespace phylo
 
       virtual void halt() ;
 
-      Cell *getNewCellPtr() ;
+      Cell *getNewCellPtr(uint32 node) ;
       void freeCellPtr(Cell *cell) ;
+      uint32 store_node(const Cell &cell) const ;
+      uint32 home_node(const Cell &cell) const ;
+      void rehome_cells() ;
 
       void openInstructionStats() ;
       void openSettings() ;
@@ -9,123 +9,307 @@ using namespace phylo::VM::Basic;
 // until we have a real wide_array implementation, we need to presize it.
 static constexpr usize WideArraySize = 5'000'000ull;
 
-ControllerImpl::ControllerImpl(Simulation &simulation) : m_Simulation(simulation),
-m_ThreadPool("VM", [this](usize idx) {pool_update(idx); }, 0),
-m_ThreadPool2("VM2", [this](usize idx) {pool_update2(idx); }, 1)
+ControllerImpl::ControllerImpl(Simulation &simulation) :
+	m_Simulation(simulation),
+	m_BatchTuner("VM (batched)", BatchRunSize, MinBatchRunSize, MaxBatchRunSize),
+	m_PerCellTuner("VM (per cell)", PerCellRunSize, MinPerCellRunSize, MaxPerCellRunSize)
 {
 	memset(m_ExecutionCounter.data(), 0, m_ExecutionCounter.size_raw());
-}
 
-ControllerImpl::~ControllerImpl() = default;
+	const usize numWorkers = Scheduler::get().worker_count();
+	m_CommandBuffers.resize(numWorkers);
+	m_Lockstep.resize(numWorkers);
+	m_Buckets.resize(numWorkers);
+	m_Profilers.resize(numWorkers);
+	m_WorkerCounters.resize(numWorkers);
+	uint16 bufferIndex = 0;
+	for (CommandBuffer &buffer : m_CommandBuffers)
+	{
+		buffer.BufferIndex = bufferIndex++;
+	}
+}
 
-void ControllerImpl::pool_update(usize threadID)
+ControllerImpl::~ControllerImpl()
 {
-	const uint numInstances = m_Instances.size();
+	if (m_Profiling)
+	{
+		m_ProfileReport.write(ProfilePath);
+	}
+}
 
-	instance_t::CounterType counter;
-	memset(&counter, 0, sizeof(counter));
+void ControllerImpl::pool_update(usize begin, usize end, usize workerID)
+{
+	CommandBuffer &commands = m_CommandBuffers[workerID];
+	instance_t::CounterType &counter = m_WorkerCounters[workerID];
+	const uint uBegin = uint(begin);
+	const uint uEnd = uint(end);
 
-	for (;;)
+	if (m_Mode == options::VMExecution::Lockstep)
 	{
-		static constexpr uint readAhead = 16;
-
-		uint uIdx = m_ThreadPoolIndex.fetch_add(readAhead);
-		uint finalIdx = std::min(uIdx + readAhead, numInstances);
-		for (; uIdx < finalIdx; ++uIdx)
+		m_Lockstep[workerID].run(&m_Instances[uBegin], uEnd - uBegin, this, counter, commands);
+	}
+	else if (m_Mode == options::VMExecution::Bucketed)
+	{
+		m_Buckets[workerID].run(&m_Instances[uBegin], uEnd - uBegin, this, counter, commands);
+	}
+	else if (m_Profiling)
+	{
+		Profiler &profiler = m_Profilers[workerID];
+		for (uint uIdx = uBegin; uIdx < uEnd; ++uIdx)
 		{
-			Instance &instance = m_Instances[uIdx];
-			instance.tick(this, counter);
+			m_Instances[uIdx].tick<true>(this, counter, commands, &profiler);
 		}
-		if (finalIdx == numInstances)
+	}
+	else
+	{
+		for (uint uIdx = uBegin; uIdx < uEnd; ++uIdx)
 		{
-			for (usize i = 0; i < counter.size(); ++i)
-			{
-				m_ExecutionCounter[i] += counter[i];
-			}
-			return;
+			m_Instances[uIdx].tick<false>(this, counter, commands, nullptr);
 		}
 	}
 }
 
-void ControllerImpl::pool_update2(usize threadID)
+void ControllerImpl::pool_update2(usize begin, usize end, usize workerID)
 {
-	const uint numTasks = m_UnserializedTasks.size();
+	const uint numKeys = m_CommandKeys.size();
+	const CommandKey *keys = m_CommandKeys.data();
+	CommandBuffer &local = m_CommandBuffers[workerID];
+
+	uint uIdx = uint(begin);
+	uint finalIdx = uint(end);
 
-	for (;;)
+	// All commands against one target must be applied by the same worker, in order. Whoever is handed the first key
+	// of a group owns the whole group, even where it runs past the end of its range.
+	while (uIdx < finalIdx && uIdx != 0 && keys[uIdx].TargetID == keys[uIdx - 1].TargetID)
 	{
-		static constexpr uint readAhead = 16;
+		++uIdx;
+	}
+	if (uIdx == finalIdx)
+	{
+		return;
+	}
+	while (finalIdx < numKeys && keys[finalIdx].TargetID == keys[finalIdx - 1].TargetID)
+	{
+		++finalIdx;
+	}
+
+	commit_group(keys + uIdx, finalIdx - uIdx, local);
+}
 
-		uint uIdx = m_ThreadPoolIndex.fetch_add(readAhead);
-		uint finalIdx = std::min(uIdx + readAhead, numTasks);
-		for (; uIdx < finalIdx; ++uIdx)
+void ControllerImpl::prepare_update(bool perCell)
+{
+	memset(m_ExecutionCounter.data(), 0, m_ExecutionCounter.size_raw());
+	if (options::VMProfiling != m_Profiling)
+	{
+		if (m_Profiling)
 		{
-			auto &task = m_UnserializedTasks[uIdx];
-			task();
+			m_ProfileReport.write(ProfilePath);
 		}
-		if (finalIdx == numTasks)
+		else
 		{
-			return;
+			m_ProfileReport.reset();
+			for (Profiler &profiler : m_Profilers)
+			{
+				profiler.reset();
+			}
 		}
+		m_Profiling = options::VMProfiling;
+	}
+
+	// The batched executors run a single instruction per cell and are not instrumented, so longer ticks and profiled
+	// ticks always go through tick().
+	m_Mode = (perCell | (options::InstructionsPerTick > 1) | m_Profiling) ? options::VMExecution::PerCell : options::ExecutionMode;
+	for (instance_t::CounterType &counter : m_WorkerCounters)
+	{
+		memset(counter.data(), 0, counter.size_raw());
 	}
 }
 
 void ControllerImpl::update()
 {
 	clock::time_point subTime = clock::get_current_time();
-	memset(m_ExecutionCounter.data(), 0, m_ExecutionCounter.size_raw());
+	prepare_update(false);
+	PhaseTuner &tuner = (m_Mode == options::VMExecution::PerCell) ? m_PerCellTuner : m_BatchTuner;
 	m_Simulation.m_TotalSerialTime += clock::get_current_time() - subTime;
 
 	subTime = clock::get_current_time();
-	m_ThreadPoolIndex = 0ull;
-	m_ThreadPool.kickoff();
+	tuner.parallel_for(m_Instances.size(), [this](usize begin, usize end, usize workerID) {
+		pool_update(begin, end, workerID);
+	});
 	m_Simulation.m_TotalParallelTime += clock::get_current_time() - subTime;
+
+	subTime = clock::get_current_time();
+	end_update();
+	m_Simulation.m_TotalSerialTime += clock::get_current_time() - subTime;
 }
 
-#include <algorithm>
+void ControllerImpl::begin_update()
+{
+	prepare_update(true);
+}
 
-void ControllerImpl::post_update()
+void ControllerImpl::update_instance(instance_t &instance)
 {
-	while ((m_SerializedTasks.size() != 0) | (m_UnserializedTasks.size() != 0))
+	const usize workerID = Scheduler::current_worker();
+	if (m_Profiling)
 	{
-		if (m_UnserializedTasks.size() != 0)
+		instance.tick<true>(this, m_WorkerCounters[workerID], m_CommandBuffers[workerID], &m_Profilers[workerID]);
+	}
+	else
+	{
+		instance.tick<false>(this, m_WorkerCounters[workerID], m_CommandBuffers[workerID], nullptr);
+	}
+}
+
+void ControllerImpl::end_update()
+{
+	for (const instance_t::CounterType &counter : m_WorkerCounters)
+	{
+		for (usize i = 0; i < counter.size(); ++i)
 		{
-			clock::time_point subTime = clock::get_current_time();
-			m_ThreadPoolIndex = 0ull;
-			m_ThreadPool2.kickoff();
-			m_Simulation.m_TotalParallelTime += clock::get_current_time() - subTime;
-			m_UnserializedTasks.clear();
+			m_ExecutionCounter[i] += counter[i];
 		}
+	}
+}
 
+void ControllerImpl::commit_group(const CommandKey *keys, uint numKeys, CommandBuffer &local)
+{
+	for (uint i = 0; i < numKeys; ++i)
+	{
+		const CommandKey &key = keys[i];
+		CommandBuffer &buffer = m_CommandBuffers[key.Buffer];
+		switch (key.Type)
 		{
-			clock::time_point subTime = clock::get_current_time();
-			if (m_SerializedTasks.size() != 0)
-			{
-				if (options::Deterministic)
-				{
-					m_SerializedTasks.sort();
-				}
-				for (auto & task : m_SerializedTasks)
-				{
-					task.Function();
-				}
-				m_SerializedTasks.clear();
-			}
-			m_Simulation.m_TotalSerialTime += clock::get_current_time() - subTime;
+		case CommandType::Split:
+			// The child inherits the parent's genome as it stands at this point in CellID order, so the offspring
+			// is built before any later transfers into the parent are applied.
+			Instance::prepare_split(buffer.Splits[key.Index], local);
+			break;
+		case CommandType::Attack:
+			Instance::commit_attack(buffer.Attacks[key.Index]);
+			break;
+		case CommandType::Transfer:
+			Instance::commit_transfer(buffer.Transfers[key.Index], buffer);
+			break;
 		}
 	}
+}
 
+void ControllerImpl::commit_commands()
+{
 	clock::time_point subTime = clock::get_current_time();
-	if (m_KillTasks.size())
+
+	usize numCommands = 0;
+	for (const CommandBuffer &buffer : m_CommandBuffers)
 	{
-		if (options::Deterministic)
-		{
-			std::sort(m_KillTasks.data(), m_KillTasks.data() + m_KillTasks.size(), [](const Cell * a, const Cell * b) { return a->getCellID() < b->getCellID(); });
-		}
-		for (Cell *cell : m_KillTasks)
+		numCommands += buffer.Keys.size();
+	}
+	if (numCommands == 0)
+	{
+		m_Simulation.m_TotalSerialTime += clock::get_current_time() - subTime;
+		return;
+	}
+
+	m_CommandKeys.resize(numCommands);
+	usize offset = 0;
+	for (const CommandBuffer &buffer : m_CommandBuffers)
+	{
+		memcpy(m_CommandKeys.data() + offset, buffer.Keys.data(), buffer.Keys.size_raw());
+		offset += buffer.Keys.size();
+	}
+
+	if (options::Deterministic)
+	{
+		radix_sort(m_CommandKeys, m_CommandKeysScratch, [](const CommandKey &key) { return key.CellID; });
+	}
+
+	// Splits allocate cells, so they are handed off serially in CellID order once the groups have built the offspring.
+	m_SplitOrder.clear();
+	for (const CommandKey &key : m_CommandKeys)
+	{
+		if (key.Type == CommandType::Split)
 		{
-			m_Simulation.killCell(*cell);
+			m_SplitOrder += &m_CommandBuffers[key.Buffer].Splits[key.Index];
 		}
-		m_KillTasks.clear();
+	}
+
+	// A cell issues at most one command per tick, and a command only mutates its target: the parent's genome and
+	// RNG for a split, the victim's armor or the recipient's genome otherwise (a transfer draws from its source's
+	// RNG, which nothing else touches that tick). Grouping by target and applying each group in CellID order is
+	// therefore bit-identical to applying everything in CellID order. The sort is stable, so the CellID order
+	// established above survives within each group.
+	radix_sort(m_CommandKeys, m_CommandKeysScratch, [](const CommandKey &key) { return key.TargetID; });
+
+	if (numCommands >= ParallelCommitThreshold)
+	{
+		m_Simulation.m_TotalSerialTime += clock::get_current_time() - subTime;
+
+		subTime = clock::get_current_time();
+		Scheduler::get().parallel_for(m_CommandKeys.size(), CommitRunSize, [this](usize begin, usize end, usize workerID) {
+			pool_update2(begin, end, workerID);
+		});
+		m_Simulation.m_TotalParallelTime += clock::get_current_time() - subTime;
+
+		subTime = clock::get_current_time();
+	}
+	else
+	{
+		commit_group(m_CommandKeys.data(), m_CommandKeys.size(), m_CommandBuffers[0]);
+	}
+
+	for (const SplitCmd *split : m_SplitOrder)
+	{
+		Instance::commit_split(*split, m_CommandBuffers[split->GenomeBuffer].Genomes[split->GenomeIndex]);
+	}
+	m_CommandKeys.clear();
+
+	m_Simulation.m_TotalSerialTime += clock::get_current_time() - subTime;
+}
+
+void ControllerImpl::commit_kills()
+{
+	usize numKills = 0;
+	for (const CommandBuffer &buffer : m_CommandBuffers)
+	{
+		numKills += buffer.Kills.size();
+	}
+	if (numKills == 0)
+	{
+		return;
+	}
+
+	m_KillTasks.resize(numKills);
+	usize offset = 0;
+	for (const CommandBuffer &buffer : m_CommandBuffers)
+	{
+		memcpy(m_KillTasks.data() + offset, buffer.Kills.data(), buffer.Kills.size_raw());
+		offset += buffer.Kills.size();
+	}
+
+	if (options::Deterministic)
+	{
+		radix_sort(m_KillTasks, m_KillTasksScratch, [](const Cell *cell) { return cell->getCellID(); });
+	}
+	for (Cell *cell : m_KillTasks)
+	{
+		m_Simulation.killCell(*cell);
+	}
+	m_KillTasks.clear();
+}
+
+void ControllerImpl::post_update()
+{
+	commit_commands();
+
+	clock::time_point subTime = clock::get_current_time();
+	if (m_Profiling)
+	{
+		m_ProfileReport.fold(m_Profilers);
+	}
+	commit_kills();
+	for (CommandBuffer &buffer : m_CommandBuffers)
+	{
+		buffer.clear();
 	}
 	m_Simulation.m_TotalSerialTime += clock::get_current_time() - subTime;
 }
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "../VMInstance.hpp"
-#include "ThreadPool.hpp"
+#include "../VMLockstep.hpp"
+#include "../VMBuckets.hpp"
+#include "PhaseTuner.hpp"
+#include "Scheduler.hpp"
 #include "Simulation/Controller.hpp"
 
 namespace phylo
@@ -21,18 +24,43 @@ namespace phylo
 
 			Simulation     &m_Simulation;
 
-			ThreadPool                 m_ThreadPool;
-			ThreadPool                 m_ThreadPool2;
-			atomic<uint>              m_ThreadPoolIndex;
-
-			mutex                    m_SerializedLock;
-			array<Task>              m_SerializedTasks;
+			WorkerLocal<CommandBuffer> m_CommandBuffers; // Recorded into without locking.
+			WorkerLocal<Lockstep>      m_Lockstep;
+			WorkerLocal<OpcodeBuckets> m_Buckets;
+			WorkerLocal<Profiler>      m_Profilers;
+			WorkerLocal<instance_t::CounterType> m_WorkerCounters; // Summed into m_ExecutionCounter.
+			ProfileReport            m_ProfileReport;
+			bool                     m_Profiling = false; // options::VMProfiling as of the start of this tick.
+			options::VMExecution     m_Mode = options::VMExecution::PerCell; // How this tick's VM phase executes.
+			PhaseTuner               m_BatchTuner;
+			PhaseTuner               m_PerCellTuner;
+			array<CommandKey>        m_CommandKeys;
+			array<CommandKey>        m_CommandKeysScratch;
+			array<SplitCmd *>        m_SplitOrder;
 			array<Cell * >              m_KillTasks;
-			mutex                    m_UnserializedLock;
-			array<function<void()>>  m_UnserializedTasks;
+			array<Cell * >              m_KillTasksScratch;
+
+			// Instances a worker runs at once in the batched modes, to begin with; cells need to land in the same run to
+			// be grouped, so the tuner keeps it well up.
+			static constexpr uint    BatchRunSize = 1024;
+			static constexpr uint    MinBatchRunSize = 256;
+			static constexpr uint    MaxBatchRunSize = 16384;
+			// Instances a worker runs at once per cell, to begin with.
+			static constexpr uint    PerCellRunSize = 16;
+			static constexpr uint    MinPerCellRunSize = 4;
+			static constexpr uint    MaxPerCellRunSize = 4096;
+			static constexpr const char *ProfilePath = "vm_profile.txt";
+			// Below this many commands, the group phase runs on the calling thread rather than waking the workers.
+			static constexpr uint    ParallelCommitThreshold = 512;
+			static constexpr uint    CommitRunSize = 16;
+
+			void prepare_update(bool perCell) ;
+			void pool_update(usize begin, usize end, usize workerID) ;
+			void pool_update2(usize begin, usize end, usize workerID) ;
 
-			void pool_update(usize threadID) ;
-			void pool_update2(usize threadID) ;
+			void commit_group(const CommandKey *keys, uint numKeys, CommandBuffer &local);
+			void commit_commands();
+			void commit_kills();
 
 		public:
 			ControllerImpl() = delete;
@@ -42,6 +70,18 @@ namespace phylo
 			void update() ;
 			void post_update() ;
 
+			// The tuner of the way the VM phase last ran.
+			const PhaseTuner &tuner() const
+			{
+				return (m_Mode == options::VMExecution::PerCell) ? m_PerCellTuner : m_BatchTuner;
+			}
+
+			// The fused tick runs the VM a tile at a time rather than through update(): begin_update(), then
+			// update_instance() on every instance from within the scheduler, then end_update(). It always runs per cell.
+			void begin_update() ;
+			void update_instance(instance_t &instance) ;
+			void end_update() ;
+
 			CounterType m_ExecutionCounter;
 		};
 	}
@@ -1,7 +1,6 @@
 #pragma once
 
 #include "../VMInstance.hpp"
-#include "ThreadPool.hpp"
 #include "Simulation/Controller.hpp"
 
 namespace phylo::VM::Basic::Instructions
@@ -0,0 +1,575 @@
+#include "phylogen.hpp"
+#include "Genome.hpp"
+
+using namespace phylo;
+using namespace phylo::VM;
+
+namespace
+{
+	// Words are mixed before hashing so that the polynomial is not linear in the raw bytecode.
+	static constexpr uint64 mix_word(uint64 word)
+	{
+		word ^= word >> 33;
+		word *= 0xFF51AFD7ED558CCDull;
+		word ^= word >> 33;
+		return word;
+	}
+
+	struct PowerTable final
+	{
+		uint64 Powers[Genome::HashPowerTableSize];
+
+		constexpr PowerTable() : Powers()
+		{
+			uint64 power = 1;
+			for (usize i = 0; i < Genome::HashPowerTableSize; ++i)
+			{
+				Powers[i] = power;
+				power *= Genome::HashBase;
+			}
+		}
+	};
+	static constexpr PowerTable HashPowers;
+}
+
+void WordBuffer::set(usize index, uint64 value)
+{
+	if (m_HashValid)
+	{
+		if (index < Genome::HashPowerTableSize)
+		{
+			m_Hash += (mix_word(value) - mix_word(m_Data[index])) * HashPowers.Powers[index];
+		}
+		else
+		{
+			m_HashValid = false;
+		}
+	}
+	m_Data[index] = value;
+}
+
+uint64 WordBuffer::hash() const
+{
+	if (!m_HashValid)
+	{
+		// Horner's rule, from the last word down.
+		uint64 hash = 0;
+		for (usize i = m_Size; i-- != 0;)
+		{
+			hash = (hash * Genome::HashBase) + mix_word(m_Data[i]);
+		}
+		m_Hash = hash;
+		m_HashValid = true;
+	}
+	return m_Hash;
+}
+
+void Genome::ColorLanes::add(word_t word)
+{
+	const uint8 *octets = (const uint8 *)&word;
+	Lanes[0] += octets[0] + octets[3] + octets[4] + octets[7];
+	Lanes[1] += octets[1] + octets[3] + octets[5] + octets[7];
+	Lanes[2] += octets[2] + octets[3] + octets[6] + octets[7];
+}
+
+void Genome::ColorLanes::subtract(word_t word)
+{
+	const uint8 *octets = (const uint8 *)&word;
+	Lanes[0] -= octets[0] + octets[3] + octets[4] + octets[7];
+	Lanes[1] -= octets[1] + octets[3] + octets[5] + octets[7];
+	Lanes[2] -= octets[2] + octets[3] + octets[6] + octets[7];
+}
+
+template <typename TFunc>
+void Genome::for_each_span_in(usize offset, usize count, TFunc &&func) const
+{
+	xassert(offset + count <= m_Size, "Genome range out of range");
+	if (count == 0)
+	{
+		return;
+	}
+
+	if (!m_Chunked)
+	{
+		func(m_Flat.data() + offset, count);
+		return;
+	}
+
+	usize chunk, chunkOffset;
+	locate(offset, chunk, chunkOffset);
+	while (count != 0)
+	{
+		const WordBuffer &words = m_Chunks[chunk];
+		const usize spanned = min(count, words.size() - chunkOffset);
+		func(words.data() + chunkOffset, spanned);
+		count -= spanned;
+		++chunk;
+		chunkOffset = 0;
+	}
+}
+
+uint64 Genome::content_hash() const
+{
+	uint64 hash;
+	if (!m_Chunked)
+	{
+		hash = m_Flat.hash();
+	}
+	else
+	{
+		// Chunk hashes are over local positions, so each is shifted up by its starting position.
+		hash = 0;
+		uint64 power = 1;
+		for (const WordBuffer &chunk : m_Chunks)
+		{
+			hash += chunk.hash() * power;
+			power *= HashPowers.Powers[chunk.size()];
+		}
+	}
+	return mix_word(hash ^ (uint64(m_Size) * 0x9E3779B97F4A7C15ull));
+}
+
+Genome::word_t Genome::fetch_chunked(usize index) const
+{
+	if (m_IndexDirty) [[unlikely]]
+	{
+		build_index();
+	}
+
+	usize chunk = m_FetchIndex[index >> FetchBlockShift];
+	while (index >= m_ChunkStarts[chunk + 1])
+	{
+		++chunk;
+	}
+	return m_Chunks[chunk][index - m_ChunkStarts[chunk]];
+}
+
+void Genome::build_index() const
+{
+	content_hash();
+	if (!m_Chunked)
+	{
+		return;
+	}
+
+	const usize numChunks = m_Chunks.size();
+	m_ChunkStarts.resize(numChunks + 1);
+	uint32 start = 0;
+	for (usize chunk = 0; chunk < numChunks; ++chunk)
+	{
+		m_ChunkStarts[chunk] = start;
+		start += uint32(m_Chunks[chunk].size());
+	}
+	m_ChunkStarts[numChunks] = start;
+
+	const usize numBlocks = (m_Size + (1ull << FetchBlockShift) - 1) >> FetchBlockShift;
+	m_FetchIndex.resize(numBlocks);
+	usize chunk = 0;
+	for (usize block = 0; block < numBlocks; ++block)
+	{
+		const usize index = block << FetchBlockShift;
+		while (index >= m_ChunkStarts[chunk + 1])
+		{
+			++chunk;
+		}
+		m_FetchIndex[block] = uint32(chunk);
+	}
+
+	m_IndexDirty = false;
+}
+
+void Genome::locate(usize index, usize &chunk, usize &offset) const
+{
+	xassert(m_Chunked && m_Chunks.size() != 0, "Locating within a genome that is not chunked");
+
+	// Descend the Fenwick tree for the number of chunks lying entirely before 'index'.
+	const usize numChunks = m_Chunks.size();
+	usize position = 0;
+	usize remaining = index;
+	for (usize step = std::bit_floor(numChunks); step != 0; step >>= 1)
+	{
+		if ((position + step <= numChunks) && (m_ChunkTree[position + step] <= remaining))
+		{
+			position += step;
+			remaining -= m_ChunkTree[position];
+		}
+	}
+
+	if (position == numChunks)
+	{
+		// Only reachable for index == size: the end of the last chunk.
+		chunk = numChunks - 1;
+		offset = m_Chunks[chunk].size();
+		return;
+	}
+	chunk = position;
+	offset = remaining;
+}
+
+void Genome::tree_rebuild()
+{
+	const usize numChunks = m_Chunks.size();
+	m_ChunkTree.resize(numChunks + 1);
+	m_ChunkTree[0] = 0;
+	for (usize i = 1; i <= numChunks; ++i)
+	{
+		m_ChunkTree[i] = uint32(m_Chunks[i - 1].size());
+	}
+	for (usize i = 1; i <= numChunks; ++i)
+	{
+		const usize parent = i + (i & (0 - i));
+		if (parent <= numChunks)
+		{
+			m_ChunkTree[parent] += m_ChunkTree[i];
+		}
+	}
+	m_IndexDirty = true;
+}
+
+void Genome::tree_add(usize chunk, int64 delta)
+{
+	const usize numChunks = m_Chunks.size();
+	for (usize i = chunk + 1; i <= numChunks; i += (i & (0 - i)))
+	{
+		m_ChunkTree[i] = uint32(int64(m_ChunkTree[i]) + delta);
+	}
+	m_IndexDirty = true;
+}
+
+void Genome::set(usize index, word_t value)
+{
+	xassert(index < m_Size, "Genome write out of range");
+	if (!m_Chunked)
+	{
+		m_Color.subtract(m_Flat[index]);
+		m_Color.add(value);
+		m_Flat.set(index, value);
+		return;
+	}
+
+	usize chunk, offset;
+	locate(index, chunk, offset);
+	WordBuffer &words = m_Chunks[chunk];
+	m_Color.subtract(words[offset]);
+	m_Color.add(value);
+	words.set(offset, value);
+}
+
+void Genome::assign(const word_t *words, usize count)
+{
+	m_Chunks.clear();
+	m_ChunkTree.clear();
+	m_Chunked = false;
+	m_IndexDirty = false;
+
+	m_Flat.resize(count);
+	m_Color = {};
+	if (count != 0)
+	{
+		memcpy(m_Flat.data(), words, count * sizeof(word_t));
+	}
+	for (usize i = 0; i < count; ++i)
+	{
+		m_Color.add(words[i]);
+	}
+	m_Size = count;
+	update_representation();
+}
+
+void Genome::resize(usize count, word_t value)
+{
+	if (count < m_Size)
+	{
+		erase(count, m_Size - count);
+		return;
+	}
+
+	while (m_Size < count)
+	{
+		push_back(value);
+	}
+}
+
+void Genome::insert(usize index, const word_t *words, usize count)
+{
+	xassert(index <= m_Size, "Genome insertion out of range");
+	if (count == 0)
+	{
+		return;
+	}
+
+	for (usize i = 0; i < count; ++i)
+	{
+		m_Color.add(words[i]);
+	}
+
+	if (!m_Chunked)
+	{
+		const usize originalSize = m_Flat.size();
+		m_Flat.resize(originalSize + count);
+		memmove(m_Flat.data() + index + count, m_Flat.data() + index, (originalSize - index) * sizeof(word_t));
+		memcpy(m_Flat.data() + index, words, count * sizeof(word_t));
+		m_Size += count;
+		update_representation();
+		return;
+	}
+
+	insert_chunked(index, words, count);
+}
+
+void Genome::insert_range(usize index, const Genome &source, usize offset, usize count)
+{
+	xassert(offset + count <= source.size(), "Genome splice source out of range");
+
+	// Copied out first, as the source may be this genome.
+	thread_local static array<word_t> spliced;
+	spliced.resize(count);
+	source.copy_to(spliced.data(), offset, count);
+	insert(index, spliced.data(), count);
+}
+
+void Genome::insert_chunked(usize index, const word_t *words, usize count)
+{
+	usize chunk, offset;
+	locate(index, chunk, offset);
+
+	WordBuffer &target = m_Chunks[chunk];
+	const usize originalSize = target.size();
+	m_Size += count;
+
+	if (originalSize + count <= MaxChunkSize) [[likely]]
+	{
+		target.resize(originalSize + count);
+		memmove(target.data() + offset + count, target.data() + offset, (originalSize - offset) * sizeof(word_t));
+		memcpy(target.data() + offset, words, count * sizeof(word_t));
+		tree_add(chunk, int64(count));
+		update_representation();
+		return;
+	}
+
+	// The chunk overflows: lay its words and the inserted ones out again as evenly sized chunks. Every piece holds at
+	// least MaxChunkSize / 2 words, so none are undersized.
+	thread_local static array<word_t> merged;
+	const usize total = originalSize + count;
+	merged.resize(total);
+	memcpy(merged.data(), target.data(), offset * sizeof(word_t));
+	memcpy(merged.data() + offset, words, count * sizeof(word_t));
+	memcpy(merged.data() + offset + count, target.data() + offset, (originalSize - offset) * sizeof(word_t));
+
+	const usize pieces = (total + MaxChunkSize - 1) / MaxChunkSize;
+	usize consumed = 0;
+	for (usize piece = 0; piece < pieces; ++piece)
+	{
+		const usize pieceSize = (total - consumed) / (pieces - piece);
+		WordBuffer pieceWords;
+		pieceWords.resize(pieceSize);
+		memcpy(pieceWords.data(), merged.data() + consumed, pieceSize * sizeof(word_t));
+		consumed += pieceSize;
+
+		if (piece == 0)
+		{
+			m_Chunks[chunk] = std::move(pieceWords);
+		}
+		else
+		{
+			m_Chunks.insert(chunk + piece, pieceWords);
+		}
+	}
+
+	tree_rebuild();
+	update_representation();
+}
+
+void Genome::erase(usize index, usize count)
+{
+	xassert(index + count <= m_Size, "Genome erasure out of range");
+	if (count == 0)
+	{
+		return;
+	}
+
+	for_each_span_in(index, count, [this](const word_t *words, usize spanned)
+	{
+		for (usize i = 0; i < spanned; ++i)
+		{
+			m_Color.subtract(words[i]);
+		}
+	});
+
+	if (!m_Chunked)
+	{
+		memmove(m_Flat.data() + index, m_Flat.data() + index + count, (m_Flat.size() - (index + count)) * sizeof(word_t));
+		m_Flat.resize(m_Flat.size() - count);
+		m_Size -= count;
+		update_representation();
+		return;
+	}
+
+	erase_chunked(index, count);
+}
+
+void Genome::erase_chunked(usize index, usize count)
+{
+	usize chunk, offset;
+	locate(index, chunk, offset);
+	const usize firstChunk = chunk;
+	m_Size -= count;
+
+	bool structural = false;
+	while (count != 0)
+	{
+		WordBuffer &words = m_Chunks[chunk];
+		const usize removed = min(count, words.size() - offset);
+		memmove(words.data() + offset, words.data() + offset + removed, (words.size() - (offset + removed)) * sizeof(word_t));
+		words.resize(words.size() - removed);
+		count -= removed;
+
+		if (words.size() == 0)
+		{
+			m_Chunks.erase_at(chunk);
+			structural = true;
+		}
+		else
+		{
+			if (!structural)
+			{
+				tree_add(chunk, -int64(removed));
+			}
+			++chunk;
+		}
+		offset = 0;
+	}
+
+	if (m_Size < FlattenThreshold)
+	{
+		if (structural)
+		{
+			tree_rebuild();
+		}
+		update_representation();
+		return;
+	}
+
+	// Only the chunk the erasure started in and the one after it can have been left undersized.
+	const usize numChunks = m_Chunks.size();
+	const bool firstSmall = (firstChunk < numChunks) && (m_Chunks[firstChunk].size() < MinChunkSize);
+	const bool nextSmall = (firstChunk + 1 < numChunks) && (m_Chunks[firstChunk + 1].size() < MinChunkSize);
+	if (firstSmall | nextSmall | structural)
+	{
+		if (nextSmall)
+		{
+			merge_small(firstChunk + 1);
+		}
+		if (firstSmall)
+		{
+			merge_small(firstChunk);
+		}
+		tree_rebuild();
+	}
+}
+
+void Genome::merge_small(usize chunk)
+{
+	const usize numChunks = m_Chunks.size();
+	if ((numChunks < 2) | (chunk >= numChunks) || m_Chunks[chunk].size() >= MinChunkSize)
+	{
+		return;
+	}
+
+	const usize left = (chunk + 1 < numChunks) ? chunk : chunk - 1;
+	const usize right = left + 1;
+
+	WordBuffer &leftWords = m_Chunks[left];
+	const WordBuffer &rightWords = m_Chunks[right];
+	const usize leftSize = leftWords.size();
+	const usize rightSize = rightWords.size();
+	const usize total = leftSize + rightSize;
+
+	if (total <= MaxChunkSize)
+	{
+		leftWords.resize(total);
+		memcpy(leftWords.data() + leftSize, rightWords.data(), rightSize * sizeof(word_t));
+		m_Chunks.erase_at(right);
+		return;
+	}
+
+	// Too large to merge, so split the pair evenly instead. Both halves exceed MaxChunkSize / 2.
+	thread_local static array<word_t> merged;
+	merged.resize(total);
+	memcpy(merged.data(), leftWords.data(), leftSize * sizeof(word_t));
+	memcpy(merged.data() + leftSize, rightWords.data(), rightSize * sizeof(word_t));
+
+	const usize half = total / 2;
+	m_Chunks[left].resize(half);
+	memcpy(m_Chunks[left].data(), merged.data(), half * sizeof(word_t));
+	m_Chunks[right].resize(total - half);
+	memcpy(m_Chunks[right].data(), merged.data() + half, (total - half) * sizeof(word_t));
+}
+
+void Genome::copy_to(word_t *destination, usize offset, usize count) const
+{
+	for_each_span_in(offset, count, [&destination](const word_t *words, usize spanned)
+	{
+		memcpy(destination, words, spanned * sizeof(word_t));
+		destination += spanned;
+	});
+}
+
+void Genome::chunkify()
+{
+	// Chunks start half full, leaving room for insertions before the first split.
+	static constexpr usize InitialChunkSize = MaxChunkSize / 2;
+
+	const usize pieces = (m_Size + InitialChunkSize - 1) / InitialChunkSize;
+	m_Chunks.clear();
+	m_Chunks.resize(pieces);
+	usize consumed = 0;
+	for (usize piece = 0; piece < pieces; ++piece)
+	{
+		const usize pieceSize = (m_Size - consumed) / (pieces - piece);
+		m_Chunks[piece].resize(pieceSize);
+		memcpy(m_Chunks[piece].data(), m_Flat.data() + consumed, pieceSize * sizeof(word_t));
+		consumed += pieceSize;
+	}
+
+	m_Flat.release();
+	m_Chunked = true;
+	tree_rebuild();
+}
+
+void Genome::flatten()
+{
+	WordBuffer flat;
+	flat.resize(m_Size);
+	usize offset = 0;
+	for (const WordBuffer &chunk : m_Chunks)
+	{
+		memcpy(flat.data() + offset, chunk.data(), chunk.size() * sizeof(word_t));
+		offset += chunk.size();
+	}
+
+	m_Flat = std::move(flat);
+	m_Chunks.clear();
+	m_ChunkTree.clear();
+	m_ChunkStarts.clear();
+	m_FetchIndex.clear();
+	m_IndexDirty = false;
+	m_Chunked = false;
+}
+
+void Genome::update_representation()
+{
+	if constexpr (!EnableChunking)
+	{
+		return;
+	}
+
+	if (!m_Chunked && m_Size >= ChunkThreshold)
+	{
+		chunkify();
+	}
+	else if (m_Chunked && m_Size < FlattenThreshold)
+	{
+		flatten();
+	}
+}
@@ -0,0 +1,285 @@
+#pragma once
+
+#include "GenomeArena.hpp"
+
+namespace phylo::VM
+{
+	// A run of bytecode words stored in the genome arena. Capacity is always the full size class, so growth within a
+	// class never reallocates. The buffer caches the polynomial hash of its words; any mutable access invalidates it,
+	// except set(), which updates it in place.
+	class WordBuffer final
+	{
+		uint64         *m_Data = nullptr;
+		uint32         m_Size = 0;
+		uint32         m_Capacity = 0;
+		mutable uint64 m_Hash = 0;
+		mutable bool   m_HashValid = false;
+
+		void reallocate(usize capacity)
+		{
+			const usize bytes = GenomeArena::rounded_size(capacity * sizeof(uint64));
+			uint64 *data = (uint64 *)GenomeArena::allocate(bytes);
+			if (m_Size != 0)
+			{
+				memcpy(data, m_Data, m_Size * sizeof(uint64));
+			}
+			release();
+			m_Data = data;
+			m_Capacity = uint32(bytes / sizeof(uint64));
+		}
+
+	public:
+		WordBuffer() = default;
+		WordBuffer(const WordBuffer &buffer)
+		{
+			*this = buffer;
+		}
+		WordBuffer(WordBuffer &&buffer) :
+			m_Data(buffer.m_Data),
+			m_Size(buffer.m_Size),
+			m_Capacity(buffer.m_Capacity),
+			m_Hash(buffer.m_Hash),
+			m_HashValid(buffer.m_HashValid)
+		{
+			buffer.m_Data = nullptr;
+			buffer.m_Size = 0;
+			buffer.m_Capacity = 0;
+		}
+		~WordBuffer()
+		{
+			release();
+		}
+
+		WordBuffer &operator = (const WordBuffer &buffer)
+		{
+			if (this != &buffer)
+			{
+				m_Size = 0;
+				resize(buffer.m_Size);
+				if (m_Size != 0)
+				{
+					memcpy(m_Data, buffer.m_Data, m_Size * sizeof(uint64));
+				}
+				m_Hash = buffer.m_Hash;
+				m_HashValid = buffer.m_HashValid;
+			}
+			return *this;
+		}
+		WordBuffer &operator = (WordBuffer &&buffer)
+		{
+			if (this != &buffer)
+			{
+				release();
+				m_Data = buffer.m_Data;
+				m_Size = buffer.m_Size;
+				m_Capacity = buffer.m_Capacity;
+				m_Hash = buffer.m_Hash;
+				m_HashValid = buffer.m_HashValid;
+				buffer.m_Data = nullptr;
+				buffer.m_Size = 0;
+				buffer.m_Capacity = 0;
+			}
+			return *this;
+		}
+
+		// Preserves the existing words; new words are uninitialized.
+		void resize(usize size)
+		{
+			if (size > m_Capacity)
+			{
+				reallocate(size);
+			}
+			m_Size = uint32(size);
+			m_HashValid = false;
+		}
+		void clear()
+		{
+			m_Size = 0;
+			m_HashValid = false;
+		}
+		void release()
+		{
+			if (m_Data)
+			{
+				GenomeArena::deallocate(m_Data, m_Capacity * sizeof(uint64));
+				m_Data = nullptr;
+			}
+			m_Size = 0;
+			m_Capacity = 0;
+			m_HashValid = false;
+		}
+
+		usize size() const
+		{
+			return m_Size;
+		}
+		uint64 *data()
+		{
+			m_HashValid = false;
+			return m_Data;
+		}
+		const uint64 *data() const
+		{
+			return m_Data;
+		}
+		uint64 operator [] (usize index) const
+		{
+			return m_Data[index];
+		}
+
+		void set(usize index, uint64 value);
+		// Sum of mix(word[i]) * HashBase^i, mod 2^64.
+		uint64 hash() const;
+	};
+
+	// A cell's bytecode. Genomes are stored flat until they reach ChunkThreshold words, at which point they switch to
+	// a chunked representation: insertions, erasures and splices then only move words within a chunk, chunks are
+	// located through a Fenwick tree of their sizes in O(log n), and fetches go through a per-64-word index in O(1).
+	class Genome final
+	{
+	public:
+		using word_t = uint64;
+		using size_type = array<word_t>::size_type; // Matches the flat bytecode array it replaced.
+
+		static constexpr bool  EnableChunking = true;
+		static constexpr usize ChunkThreshold = 1024;  // Flat genomes reaching this size become chunked.
+		static constexpr usize FlattenThreshold = 512; // Chunked genomes shrinking below this become flat again.
+		static constexpr usize MinChunkSize = 64;
+		static constexpr usize MaxChunkSize = 256;
+		static constexpr usize FetchBlockShift = 6;    // The fetch index has an entry per 64 words, no more than MinChunkSize.
+		static_assert((1ull << FetchBlockShift) <= MinChunkSize, "A fetch block must never span more than two chunks");
+
+		// The content hash is polynomial over mixed words, cached per chunk (or for the whole flat genome) and only
+		// recomputed for runs that were edited. The colour fingerprint is the additive byte-lane sum the bytecode colour
+		// has always been derived from; being position independent, every edit updates it in O(edit size).
+		static constexpr uint64 HashBase = 0x100000001B3ull;
+		static constexpr usize  HashPowerTableSize = ChunkThreshold;
+		static_assert(MaxChunkSize < HashPowerTableSize, "Chunk hashes are combined through the power table");
+
+		struct ColorLanes final
+		{
+			uint8 Lanes[3] = {};
+
+			void add(word_t word);
+			void subtract(word_t word);
+		};
+
+	private:
+		WordBuffer            m_Flat;
+		array<WordBuffer>     m_Chunks;
+		array<uint32>         m_ChunkTree;           // 1-based Fenwick tree over chunk sizes.
+		mutable array<uint32> m_ChunkStarts;         // First word of each chunk plus a trailing end sentinel.
+		mutable array<uint32> m_FetchIndex;          // The chunk holding word (i << FetchBlockShift).
+		mutable bool          m_IndexDirty = false;
+		usize                 m_Size = 0;
+		ColorLanes            m_Color;
+		bool                  m_Chunked = false;
+
+		word_t fetch_chunked(usize index) const;
+
+		template <typename TFunc>
+		void for_each_span_in(usize offset, usize count, TFunc &&func) const;
+		void locate(usize index, usize &chunk, usize &offset) const;
+
+		void tree_rebuild();
+		void tree_add(usize chunk, int64 delta);
+
+		void insert_chunked(usize index, const word_t *words, usize count);
+		void erase_chunked(usize index, usize count);
+		void merge_small(usize chunk);
+
+		void chunkify();
+		void flatten();
+		void update_representation();
+
+	public:
+		Genome() = default;
+		Genome(const Genome &) = default;
+		Genome(Genome &&) = default;
+		Genome &operator = (const Genome &) = default;
+		Genome &operator = (Genome &&) = default;
+
+		size_type size() const
+		{
+			return size_type(m_Size);
+		}
+
+		bool is_chunked() const
+		{
+			return m_Chunked;
+		}
+
+		word_t operator [] (usize index) const
+		{
+			xassert(index < m_Size, "Genome fetch out of range");
+			if (!m_Chunked) [[likely]]
+			{
+				return m_Flat[index];
+			}
+			return fetch_chunked(index);
+		}
+
+		void set(usize index, word_t value);
+
+		// Byte-granular access, in the little-endian layout the flat bytecode always had.
+		uint8 byte(usize offset) const
+		{
+			return uint8((*this)[offset / sizeof(word_t)] >> ((offset % sizeof(word_t)) * 8));
+		}
+		void set_byte(usize offset, uint8 value)
+		{
+			const usize shift = (offset % sizeof(word_t)) * 8;
+			const word_t word = (*this)[offset / sizeof(word_t)];
+			set(offset / sizeof(word_t), (word & ~(word_t(0xFF) << shift)) | (word_t(value) << shift));
+		}
+
+		void assign(const word_t *words, usize count);
+		void resize(usize count, word_t value = 0);
+		void truncate(usize count)
+		{
+			if (count < m_Size)
+			{
+				erase(count, m_Size - count);
+			}
+		}
+
+		void insert(usize index, word_t value)
+		{
+			insert(index, &value, 1);
+		}
+		void insert(usize index, const word_t *words, usize count);
+		// Inserts a copy of source's words [offset, offset + count). The source may be this genome.
+		void insert_range(usize index, const Genome &source, usize offset, usize count);
+		void push_back(word_t value)
+		{
+			insert(m_Size, &value, 1);
+		}
+		void erase(usize index, usize count = 1);
+
+		void copy_to(word_t *destination, usize offset, usize count) const;
+
+		// Calls func(const word_t *words, usize count) over the genome's contiguous runs, in order.
+		template <typename TFunc>
+		void for_each_span(TFunc &&func) const
+		{
+			if (!m_Chunked)
+			{
+				func(m_Flat.data(), m_Flat.size());
+				return;
+			}
+			for (const WordBuffer &chunk : m_Chunks)
+			{
+				func(chunk.data(), chunk.size());
+			}
+		}
+
+		// Eagerly rebuilds the fetch index and the content hash; otherwise they are rebuilt on first use after an edit.
+		void build_index() const;
+
+		uint64 content_hash() const;
+		const ColorLanes &color_lanes() const
+		{
+			return m_Color;
+		}
+	};
+}
@@ -0,0 +1,122 @@
+#include "phylogen.hpp"
+#include "Simulation/Simulation.hpp"
+
+using namespace phylo;
+using namespace phylo::VM;
+
+namespace
+{
+	static bool is_jump(VM::Operation opcode)
+	{
+		return (opcode >= VM::Operation::Jump) & (opcode <= VM::Operation::Jump_LEZ);
+	}
+}
+
+void GenomeAnalysis::analyze(const Genome &code)
+{
+	const uint size = uint(code.size());
+	if (size == 0)
+	{
+		return;
+	}
+	Slots.clear();
+	Slots.resize(size);
+	memset(Slots.data(), 0, Slots.size_raw());
+	ReachableCount = 0;
+	IndirectJumps = false;
+	Passive = true;
+
+	thread_local static array<uint64> words;
+	words.resize(size);
+	code.copy_to(words.data(), 0, size);
+
+	for (uint slot = 0; slot < size; ++slot)
+	{
+		const VM::Operation opcode = VM::Operation(Instance::decode_opcode(words[slot]));
+		Slots[slot].Flags = Instance::is_register_op(uint16(opcode)) ? RegisterOnly : 0;
+		Slots[slot].StaticCost = Instance::op_cost(opcode);
+	}
+
+	// Straight-line runs, from the end backwards.
+	for (uint slot = size; slot-- > 0;)
+	{
+		const VM::Operation opcode = VM::Operation(Instance::decode_opcode(words[slot]));
+		if (!(Slots[slot].Flags & RegisterOnly) | is_jump(opcode))
+		{
+			continue;
+		}
+		const uint following = (slot + 1 < size) ? Slots[slot + 1].PureRun : 0;
+		Slots[slot].PureRun = uint8(min(following + 1, uint(traits<uint8>::max)));
+	}
+
+	// Reachability. Jumps compute their target the way Instance::op_Jump does: the offset is added to the advanced
+	// program counter as an unsigned integer, then reduced by the genome size.
+	thread_local static array<uint> pending;
+	pending.clear();
+	pending.push_back(0);
+	Slots[0].Flags |= Reachable;
+	auto visit = [&](uint slot)
+	{
+		if (!(Slots[slot].Flags & Reachable))
+		{
+			Slots[slot].Flags |= Reachable;
+			pending.push_back(slot);
+		}
+	};
+	while (pending.size() != 0)
+	{
+		const uint slot = pending.back();
+		pending.pop_back();
+
+		const Instance::DecodedOperation decoded = Instance::decode(words[slot]);
+		const uint next = (slot + 1) % size;
+
+		switch (decoded.Opcode)
+		{
+		case VM::Operation::Split:
+		case VM::Operation::Attack:
+		case VM::Operation::Transfer:
+			Passive = false;
+			break;
+		default:
+			break;
+		}
+
+		if (!is_jump(decoded.Opcode))
+		{
+			visit(next);
+			continue;
+		}
+
+		if (decoded.Operand1IsRegister)
+		{
+			IndirectJumps = true;
+			break;
+		}
+		const uint target = (next + uint(int(int16(decoded.Operand1)))) % size;
+		Slots[target].Flags |= JumpTarget;
+		visit(target);
+		if (decoded.Opcode != VM::Operation::Jump)
+		{
+			visit(next);
+		}
+	}
+
+	if (IndirectJumps)
+	{
+		for (uint slot = 0; slot < size; ++slot)
+		{
+			Slots[slot].Flags |= Reachable;
+			const VM::Operation opcode = VM::Operation(Instance::decode_opcode(words[slot]));
+			if ((opcode == VM::Operation::Split) | (opcode == VM::Operation::Attack) | (opcode == VM::Operation::Transfer))
+			{
+				Passive = false;
+			}
+		}
+	}
+
+	for (const Slot &info : Slots)
+	{
+		ReachableCount += (info.Flags & Reachable) ? 1 : 0;
+	}
+}
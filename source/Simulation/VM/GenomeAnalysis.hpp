@@ -0,0 +1,45 @@
+#pragma once
+
+namespace phylo::VM
+{
+	class Genome;
+
+	// What can be known about a genome from its code alone. Computed once when a genome is interned, and shared by every
+	// cell running it.
+	//
+	// Reachability is traced from slot 0, where new cells start, following fallthrough and both edges of every
+	// conditional jump. A reachable jump whose offset comes from a register could land anywhere, so it makes the whole
+	// genome reachable. A cell whose genome was edited in place keeps its program counter and may be running code that
+	// is unreachable from the entry; consumers may use this to spend less effort there, never to refuse to run it.
+	struct GenomeAnalysis final
+	{
+		enum SlotFlags : uint8
+		{
+			Reachable    = 1 << 0,
+			JumpTarget   = 1 << 1, // Named by a reachable jump with an immediate offset.
+			RegisterOnly = 1 << 2, // Touches only the registers and program counter (Instance::is_register_op).
+		};
+
+		// What Instance::op_cost() gives for an instruction whose cost depends on its operands, the cell or the options.
+		static constexpr uint8 DynamicCost = traits<uint8>::max;
+
+		struct Slot final
+		{
+			uint8 Flags = 0;
+			uint8 PureRun = 0;    // Register-only, non-jump instructions from here on in a straight line, saturating.
+			uint8 StaticCost = 0; // Instance::op_cost() of the slot's opcode.
+		};
+
+		array<Slot> Slots;
+		uint32      ReachableCount = 0;
+		bool        IndirectJumps = false; // A reachable jump takes its offset from a register.
+		bool        Passive = true;        // No reachable Split, Attack or Transfer.
+
+		void analyze(const Genome &code);
+
+		bool is_reachable(uint slot) const
+		{
+			return (Slots[slot].Flags & Reachable) != 0;
+		}
+	};
+}
@@ -0,0 +1,280 @@
+#include "phylogen.hpp"
+#include "GenomeArena.hpp"
+
+using namespace phylo;
+using namespace phylo::VM;
+
+namespace
+{
+	struct FreeBlock final
+	{
+		FreeBlock *Next;
+	};
+
+	// Live bytes are tallied per thread and folded into the shared counter only once they drift this far.
+	static constexpr int64 LiveFlushThreshold = 64 * 1024;
+
+	struct alignas(64) SharedClass final
+	{
+		mutex     Lock;
+		FreeBlock *Head = nullptr;
+		usize     Count = 0;
+	};
+
+	struct SharedState final
+	{
+		array<SharedClass, GenomeArena::NumClasses> Classes;
+
+		// Each class carves its own slab, so that a slab's blocks are all of one size.
+		mutex          SlabLock;
+		uint8          *SlabCursors[GenomeArena::NumClasses] = {};
+		uint8          *SlabEnds[GenomeArena::NumClasses] = {};
+
+		alignas(64) atomic<int64>  BytesLive = { 0 };
+		alignas(64) atomic<uint64> BytesReserved = { 0 };
+	};
+
+	// Never destroyed: thread caches flush into it on thread exit, which may be after static destruction.
+	static SharedState &shared()
+	{
+		static SharedState *state = new SharedState;
+		return *state;
+	}
+
+	// Slabs are aligned to their size, so a block's slab is its address rounded down.
+	static uptr slab_of(const void *block)
+	{
+		return uptr(block) & ~uptr(GenomeArena::SlabSize - 1);
+	}
+
+	// Carves 'count' blocks of the given class out of its current slab, starting a new slab when it runs out.
+	// The tail of a retired slab is abandoned; it is less than one block.
+	static FreeBlock *carve(usize classIndex, uint count)
+	{
+		SharedState &state = shared();
+		const usize blockSize = GenomeArena::class_size(classIndex);
+		uint8 *&cursor = state.SlabCursors[classIndex];
+		uint8 *&end = state.SlabEnds[classIndex];
+
+		scoped_lock _lock(state.SlabLock);
+
+		FreeBlock *head = nullptr;
+		for (uint i = 0; i < count; ++i)
+		{
+			if (usize(end - cursor) < blockSize)
+			{
+				cursor = (uint8 *)::operator new(GenomeArena::SlabSize, std::align_val_t(GenomeArena::SlabSize));
+				end = cursor + GenomeArena::SlabSize;
+				state.BytesReserved.fetch_add(GenomeArena::SlabSize);
+			}
+			FreeBlock *block = (FreeBlock *)cursor;
+			cursor += blockSize;
+			block->Next = head;
+			head = block;
+		}
+		return head;
+	}
+
+	struct ThreadCache final
+	{
+		FreeBlock *Heads[GenomeArena::NumClasses] = {};
+		uint      Counts[GenomeArena::NumClasses] = {};
+		int64     LiveDelta = 0;
+
+		void account(int64 bytes)
+		{
+			LiveDelta += bytes;
+			if ((LiveDelta >= LiveFlushThreshold) | (LiveDelta <= -LiveFlushThreshold))
+			{
+				shared().BytesLive.fetch_add(LiveDelta);
+				LiveDelta = 0;
+			}
+		}
+
+		void refill(usize classIndex)
+		{
+			static constexpr uint Batch = GenomeArena::CacheLimit / 2;
+			SharedClass &sharedClass = shared().Classes[classIndex];
+			{
+				scoped_lock _lock(sharedClass.Lock);
+				uint taken = 0;
+				while ((taken < Batch) & (sharedClass.Head != nullptr))
+				{
+					FreeBlock *block = sharedClass.Head;
+					sharedClass.Head = block->Next;
+					block->Next = Heads[classIndex];
+					Heads[classIndex] = block;
+					++taken;
+				}
+				sharedClass.Count -= taken;
+				Counts[classIndex] += taken;
+			}
+			if (Counts[classIndex] == 0)
+			{
+				Heads[classIndex] = carve(classIndex, Batch);
+				Counts[classIndex] = Batch;
+			}
+		}
+
+		// Returns 'count' blocks of a class to the shared list.
+		void spill(usize classIndex, uint count)
+		{
+			FreeBlock *first = Heads[classIndex];
+			FreeBlock *last = first;
+			for (uint i = 1; i < count; ++i)
+			{
+				last = last->Next;
+			}
+			Heads[classIndex] = last->Next;
+			Counts[classIndex] -= count;
+
+			SharedClass &sharedClass = shared().Classes[classIndex];
+			scoped_lock _lock(sharedClass.Lock);
+			last->Next = sharedClass.Head;
+			sharedClass.Head = first;
+			sharedClass.Count += count;
+		}
+
+		~ThreadCache()
+		{
+			for (usize classIndex = 0; classIndex < GenomeArena::NumClasses; ++classIndex)
+			{
+				if (Counts[classIndex] != 0)
+				{
+					spill(classIndex, Counts[classIndex]);
+				}
+			}
+			shared().BytesLive.fetch_add(LiveDelta);
+		}
+	};
+
+	thread_local static ThreadCache t_Cache;
+}
+
+void *GenomeArena::allocate(usize bytes)
+{
+	if (bytes > MaxClassBytes) [[unlikely]]
+	{
+		SharedState &state = shared();
+		state.BytesLive.fetch_add(int64(bytes));
+		state.BytesReserved.fetch_add(bytes);
+		return ::operator new(bytes, std::align_val_t(64));
+	}
+
+	const usize classIndex = class_index(bytes);
+	ThreadCache &cache = t_Cache;
+	if (cache.Counts[classIndex] == 0) [[unlikely]]
+	{
+		cache.refill(classIndex);
+	}
+
+	FreeBlock *block = cache.Heads[classIndex];
+	cache.Heads[classIndex] = block->Next;
+	--cache.Counts[classIndex];
+	cache.account(int64(class_size(classIndex)));
+	return block;
+}
+
+void GenomeArena::deallocate(void *block, usize bytes)
+{
+	if (block == nullptr)
+	{
+		return;
+	}
+
+	if (bytes > MaxClassBytes) [[unlikely]]
+	{
+		SharedState &state = shared();
+		state.BytesLive.fetch_sub(int64(bytes));
+		state.BytesReserved.fetch_sub(bytes);
+		::operator delete(block, std::align_val_t(64));
+		return;
+	}
+
+	const usize classIndex = class_index(bytes);
+	ThreadCache &cache = t_Cache;
+	FreeBlock *freed = (FreeBlock *)block;
+	freed->Next = cache.Heads[classIndex];
+	cache.Heads[classIndex] = freed;
+	cache.account(-int64(class_size(classIndex)));
+
+	if (++cache.Counts[classIndex] > CacheLimit) [[unlikely]]
+	{
+		cache.spill(classIndex, CacheLimit / 2);
+	}
+}
+
+void GenomeArena::trim()
+{
+	SharedState &state = shared();
+	array<FreeBlock *> blocks;
+	for (usize classIndex = 0; classIndex < NumClasses; ++classIndex)
+	{
+		const usize blocksPerSlab = SlabSize / class_size(classIndex);
+		SharedClass &sharedClass = state.Classes[classIndex];
+		scoped_lock _lock(sharedClass.Lock);
+		if (sharedClass.Count < blocksPerSlab)
+		{
+			continue;
+		}
+
+		// Sorted, a slab's free blocks are a run; a run as long as the slab holds blocks is the whole slab. The slab
+		// still being carved never has that many, as its uncarved tail is not in the list.
+		blocks.clear();
+		for (FreeBlock *block = sharedClass.Head; block != nullptr; block = block->Next)
+		{
+			blocks.push_back(block);
+		}
+		std::sort(blocks.data(), blocks.data() + blocks.size());
+
+		FreeBlock *head = nullptr;
+		usize count = 0;
+		usize runStart = 0;
+		while (runStart < blocks.size())
+		{
+			const uptr slab = slab_of(blocks[runStart]);
+			usize runEnd = runStart + 1;
+			while ((runEnd < blocks.size()) && (slab_of(blocks[runEnd]) == slab))
+			{
+				++runEnd;
+			}
+
+			if ((runEnd - runStart) == blocksPerSlab)
+			{
+				{
+					// A slab carved to its end may still be the class's cursor; the next carve must not use it.
+					scoped_lock _slabLock(state.SlabLock);
+					const uptr cursor = uptr(state.SlabCursors[classIndex]);
+					if ((cursor != 0) && (slab_of((const void *)(cursor - 1)) == slab))
+					{
+						state.SlabCursors[classIndex] = nullptr;
+						state.SlabEnds[classIndex] = nullptr;
+					}
+				}
+				::operator delete((void *)slab, std::align_val_t(SlabSize));
+				state.BytesReserved.fetch_sub(SlabSize);
+			}
+			else
+			{
+				for (usize i = runStart; i < runEnd; ++i)
+				{
+					blocks[i]->Next = head;
+					head = blocks[i];
+				}
+				count += runEnd - runStart;
+			}
+			runStart = runEnd;
+		}
+		sharedClass.Head = head;
+		sharedClass.Count = count;
+	}
+}
+
+GenomeArena::Statistics GenomeArena::get_statistics()
+{
+	const SharedState &state = shared();
+	return {
+		uint64(max(state.BytesLive.load(), int64(0))),
+		state.BytesReserved.load()
+	};
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+namespace phylo::VM
+{
+	// Allocator for genome storage. Requests are rounded up to a size class: powers of two up to 256 bytes, then steps
+	// of 64 words up to 8 KiB, which covers every chunk and every flat genome below the chunking threshold. Each thread
+	// keeps a small free list per class, so allocation and release on VM threads do not lock; threads trade half a
+	// cache at a time with the shared lists, which are refilled by carving 1 MiB slabs. Larger requests go to the heap.
+	// Each slab holds one class, so trim() can hand a slab whose blocks are all free back to the heap, where any other
+	// class can take it up; a population whose genome lengths drift then does not keep every class's high-water mark.
+	class GenomeArena final
+	{
+	public:
+		static constexpr usize NumSmallClasses = 4;      // 32, 64, 128 and 256 bytes.
+		static constexpr usize ClassStep = 64 * sizeof(uint64);
+		static constexpr usize MaxClassBytes = 8192;
+		static constexpr usize NumClasses = NumSmallClasses + (MaxClassBytes / ClassStep);
+		static constexpr usize SlabSize = 1ull << 20;
+		static constexpr uint  CacheLimit = 64;          // Blocks a thread keeps per class before returning half.
+
+		struct Statistics final
+		{
+			uint64 BytesLive;     // Handed out and not yet freed, including size class rounding.
+			uint64 BytesReserved; // Slabs carved plus large allocations outstanding.
+		};
+
+		static constexpr usize class_index(usize bytes)
+		{
+			if (bytes <= (32ull << (NumSmallClasses - 1)))
+			{
+				return (bytes <= 32) ? 0 : usize(std::bit_width(bytes - 1)) - 5;
+			}
+			return NumSmallClasses + ((bytes - 1) / ClassStep);
+		}
+		static constexpr usize class_size(usize index)
+		{
+			return (index < NumSmallClasses) ? (32ull << index) : ((index - NumSmallClasses + 1) * ClassStep);
+		}
+		// The number of bytes actually reserved for a request of the given size.
+		static constexpr usize rounded_size(usize bytes)
+		{
+			return (bytes > MaxClassBytes) ? bytes : class_size(class_index(bytes));
+		}
+
+		static void *allocate(usize bytes);
+		// 'bytes' must be the size the block was allocated with, or its rounded size.
+		static void deallocate(void *block, usize bytes);
+
+		// Releases every slab all of whose blocks are in the shared lists. Blocks in threads' caches keep their slabs,
+		// so this is best run at a serial point, after the VM threads have spilled what they do not need.
+		static void trim();
+
+		static Statistics get_statistics();
+	};
+}
@@ -0,0 +1,228 @@
+#include "phylogen.hpp"
+#include "Simulation/Simulation.hpp"
+
+using namespace phylo;
+using namespace phylo::VM;
+
+GenomeStore &GenomeStore::get()
+{
+	// Never destroyed: cells may still release their genomes during static destruction.
+	static GenomeStore *store = new GenomeStore;
+	return *store;
+}
+
+GenomeEntry::~GenomeEntry()
+{
+	drop_native();
+}
+
+void GenomeEntry::drop_native()
+{
+	JitCode *native = Native.load();
+	Native.store(nullptr);
+	delete native;
+	NativeClaimed.store(false);
+	Executions.store(0);
+}
+
+void GenomeStore::grow(Shard &shard)
+{
+	array<GenomeEntry *> buckets;
+	buckets.resize(max(usize(shard.Buckets.size()) * 2, usize(64)), nullptr);
+	const usize mask = buckets.size() - 1;
+	for (GenomeEntry *head : shard.Buckets)
+	{
+		while (head)
+		{
+			GenomeEntry *next = head->Next;
+			GenomeEntry *&bucket = buckets[head->ContentHash & mask];
+			head->Next = bucket;
+			bucket = head;
+			head = next;
+		}
+	}
+	shard.Buckets = std::move(buckets);
+}
+
+void GenomeStore::account(const GenomeEntry &entry, int sign)
+{
+	const GenomeAnalysis &analysis = entry.Analysis;
+	if (sign > 0)
+	{
+		m_CodeSlots.fetch_add(analysis.Slots.size());
+		m_ReachableSlots.fetch_add(analysis.ReachableCount);
+		m_PassiveCount.fetch_add(analysis.Passive ? 1 : 0);
+	}
+	else
+	{
+		m_CodeSlots.fetch_sub(analysis.Slots.size());
+		m_ReachableSlots.fetch_sub(analysis.ReachableCount);
+		m_PassiveCount.fetch_sub(analysis.Passive ? 1 : 0);
+	}
+}
+
+GenomeEntry *GenomeStore::intern(GenomeEntry *entry)
+{
+	xassert(!entry->Interned && entry->References.load() == 1, "Only a detached entry with a single holder can be interned");
+
+	const Genome &code = entry->Code;
+	entry->ContentHash = code.content_hash();
+
+	Shard &shard = shard_for(entry->ContentHash);
+	{
+		scoped_lock _lock(shard.Lock);
+
+		if (shard.Buckets.size() != 0)
+		{
+			for (GenomeEntry *found = shard.Buckets[entry->ContentHash & (shard.Buckets.size() - 1)]; found; found = found->Next)
+			{
+				if (found->ContentHash != entry->ContentHash || found->Code.size() != code.size())
+				{
+					continue;
+				}
+
+				bool equal = true;
+				for (usize i = 0; equal & (i < code.size()); ++i)
+				{
+					equal = (found->Code[i] == code[i]);
+				}
+				if (equal)
+				{
+					found->References.fetch_add(1);
+					delete entry;
+					return found;
+				}
+			}
+		}
+
+		if (shard.Count >= shard.Buckets.size())
+		{
+			grow(shard);
+		}
+		GenomeEntry *&bucket = shard.Buckets[entry->ContentHash & (shard.Buckets.size() - 1)];
+		entry->Next = bucket;
+		bucket = entry;
+		++shard.Count;
+
+		// Shared entries are read from many threads, so nothing may be left to build lazily.
+		entry->Code.build_index();
+		entry->ColorHash = Instance::compute_bytecode_hash(entry->Code);
+		entry->Analysis.analyze(entry->Code);
+		entry->ID = m_NextID.fetch_add(1);
+		entry->Interned = true;
+	}
+	m_UniqueCount.fetch_add(1);
+	account(*entry, 1);
+	return entry;
+}
+
+void GenomeStore::release(GenomeEntry *entry)
+{
+	if (!entry->Interned)
+	{
+		xassert(entry->References.load() == 1, "Detached genomes have a single holder");
+		delete entry;
+		return;
+	}
+
+	// References only ever rise from zero inside intern, under the shard lock, so the last reference is also only
+	// dropped under it. Any other release is a plain decrement.
+	uint32 references = entry->References.load();
+	while (references > 1)
+	{
+		if (entry->References.compare_exchange_weak(references, references - 1))
+		{
+			return;
+		}
+	}
+
+	Shard &shard = shard_for(entry->ContentHash);
+	{
+		scoped_lock _lock(shard.Lock);
+		if (entry->References.fetch_sub(1) != 1)
+		{
+			return;
+		}
+
+		GenomeEntry **link = &shard.Buckets[entry->ContentHash & (shard.Buckets.size() - 1)];
+		while (*link != entry)
+		{
+			link = &(*link)->Next;
+		}
+		*link = entry->Next;
+		--shard.Count;
+	}
+	m_UniqueCount.fetch_sub(1);
+	account(*entry, -1);
+	delete entry;
+}
+
+GenomeEntry *GenomeStore::detach(GenomeEntry *entry)
+{
+	if (!entry->Interned)
+	{
+		return entry;
+	}
+
+	// The sole holder can take the entry itself out of the table rather than copying it.
+	Shard &shard = shard_for(entry->ContentHash);
+	{
+		scoped_lock _lock(shard.Lock);
+		if (entry->References.load() == 1)
+		{
+			GenomeEntry **link = &shard.Buckets[entry->ContentHash & (shard.Buckets.size() - 1)];
+			while (*link != entry)
+			{
+				link = &(*link)->Next;
+			}
+			*link = entry->Next;
+			--shard.Count;
+
+			entry->Next = nullptr;
+			entry->Interned = false;
+			entry->ID = 0;
+			// The holder is about to edit the code, which the native translation was made from.
+			entry->drop_native();
+			m_UniqueCount.fetch_sub(1);
+			account(*entry, -1);
+			return entry;
+		}
+	}
+
+	GenomeEntry *copy = new GenomeEntry;
+	copy->Code = entry->Code;
+	copy->References.store(1);
+	release(entry);
+	return copy;
+}
+
+void GenomeStore::record_executions(GenomeEntry *entry, uint64 count)
+{
+	if (!entry->Interned)
+	{
+		return;
+	}
+
+	const uint64 executions = entry->Executions.fetch_add(count) + count;
+	if ((executions < uint64(max(options::NativeTierThreshold, 0))) | entry->NativeClaimed.load())
+	{
+		return;
+	}
+
+	bool claimed = false;
+	if (entry->NativeClaimed.compare_exchange_weak(claimed, true))
+	{
+		entry->Native.store(JitCode::compile(entry->Code, entry->Analysis));
+	}
+}
+
+void GenomeRef::assign(Genome &&genome)
+{
+	GenomeEntry *entry = new GenomeEntry;
+	entry->Code = std::move(genome);
+	entry->References.store(1);
+	entry = GenomeStore::get().intern(entry);
+
+	reset();
+	m_Entry = entry;
+}
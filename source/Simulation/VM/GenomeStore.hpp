@@ -0,0 +1,224 @@
+#pragma once
+
+#include "Genome.hpp"
+#include "GenomeAnalysis.hpp"
+
+namespace phylo::VM
+{
+	class JitCode;
+
+	// An interned genome. While interned it is immutable and may be shared by any number of cells; a holder that wants
+	// to edit it takes a private, detached copy first (or the entry itself, if it is the only holder).
+	struct GenomeEntry final
+	{
+		Genome         Code;
+		vector4F       ColorHash;          // Bytecode hash colour, computed once per distinct genome.
+		GenomeAnalysis Analysis;           // Computed on interning; stale while detached.
+		uint64         ContentHash = 0;
+		uint64         ID = 0;             // Assigned on first interning; 0 while detached.
+		atomic<uint32> References = { 0 }; // The number of cells holding this genome.
+		GenomeEntry    *Next = nullptr;    // Bucket chain.
+		bool           Interned = false;
+
+		atomic<uint64>    Executions = { 0 };      // Instructions interpreted by all holders, sampled.
+		atomic<JitCode *> Native = { nullptr };    // Published once compiled; lives as long as the entry.
+		atomic<bool>      NativeClaimed = { false };
+
+		GenomeEntry() = default;
+		~GenomeEntry();
+		void drop_native();
+
+		static void *operator new(usize size)
+		{
+			return GenomeArena::allocate(size);
+		}
+		static void operator delete(void *block, usize size)
+		{
+			GenomeArena::deallocate(block, size);
+		}
+	};
+
+	// Process-wide, content-addressed table of every live genome. Lookups and removals lock one of a set of shards
+	// chosen by content hash, so births and deaths on different threads rarely contend.
+	class GenomeStore final
+	{
+		static constexpr uint NumShards = 64;
+
+		struct alignas(64) Shard final
+		{
+			mutex                 Lock;
+			array<GenomeEntry *>  Buckets;
+			usize                 Count = 0;
+		};
+
+		array<Shard, NumShards> m_Shards;
+		atomic<uint64>          m_NextID = { 1 };
+		atomic<uint64>          m_UniqueCount = { 0 };
+		atomic<uint64>          m_CodeSlots = { 0 };
+		atomic<uint64>          m_ReachableSlots = { 0 };
+		atomic<uint64>          m_PassiveCount = { 0 };
+
+		Shard &shard_for(uint64 contentHash)
+		{
+			return m_Shards[(contentHash >> 58) % NumShards];
+		}
+		static void grow(Shard &shard);
+		// Adds an entry's analysis to the totals, or with a negative sign takes it out again.
+		void account(const GenomeEntry &entry, int sign);
+
+	public:
+		struct Statistics final
+		{
+			uint64 CodeSlots;      // Over all unique genomes.
+			uint64 ReachableSlots;
+			uint64 PassiveGenomes; // Genomes that can never split, attack or transfer.
+		};
+
+		static GenomeStore &get();
+
+		// Interns a detached entry. Returns either that entry or an existing identical one, in which case the detached
+		// entry is freed. The caller's single reference is transferred to the returned entry.
+		GenomeEntry *intern(GenomeEntry *entry);
+		// Drops a reference, freeing the entry when it was the last.
+		void release(GenomeEntry *entry);
+		// Makes an entry safe to edit: the entry itself if the caller is its only holder, otherwise a detached copy.
+		GenomeEntry *detach(GenomeEntry *entry);
+
+		// Adds to an interned genome's execution tally, compiling it to native code once the tally crosses the
+		// threshold. Only the thread that claims the entry compiles; everyone else keeps interpreting until it is ready.
+		void record_executions(GenomeEntry *entry, uint64 count);
+
+		uint64 unique_count() const
+		{
+			return m_UniqueCount.load();
+		}
+		Statistics get_statistics() const
+		{
+			return { m_CodeSlots.load(), m_ReachableSlots.load(), m_PassiveCount.load() };
+		}
+	};
+
+	// A cell's handle on its genome. Copies share the underlying entry; edit() copies on write and seal() interns the
+	// result again, so identical genomes are stored once however they arose.
+	class GenomeRef final
+	{
+		GenomeEntry *m_Entry = nullptr;
+
+	public:
+		GenomeRef() = default;
+		GenomeRef(const GenomeRef &ref) : m_Entry(ref.m_Entry)
+		{
+			if (m_Entry)
+			{
+				m_Entry->References.fetch_add(1);
+			}
+		}
+		GenomeRef(GenomeRef &&ref) : m_Entry(ref.m_Entry)
+		{
+			ref.m_Entry = nullptr;
+		}
+		~GenomeRef()
+		{
+			reset();
+		}
+
+		GenomeRef &operator = (const GenomeRef &ref)
+		{
+			if (ref.m_Entry)
+			{
+				ref.m_Entry->References.fetch_add(1);
+			}
+			reset();
+			m_Entry = ref.m_Entry;
+			return *this;
+		}
+		GenomeRef &operator = (GenomeRef &&ref)
+		{
+			if (this != &ref)
+			{
+				reset();
+				m_Entry = ref.m_Entry;
+				ref.m_Entry = nullptr;
+			}
+			return *this;
+		}
+
+		void reset()
+		{
+			if (m_Entry)
+			{
+				GenomeStore::get().release(m_Entry);
+				m_Entry = nullptr;
+			}
+		}
+
+		void assign(Genome &&genome);
+		void assign(const uint64 *words, usize count)
+		{
+			Genome genome;
+			genome.assign(words, count);
+			assign(std::move(genome));
+		}
+
+		const Genome &get() const
+		{
+			xassert(m_Entry != nullptr, "Empty genome reference");
+			return m_Entry->Code;
+		}
+		Genome::size_type size() const
+		{
+			return get().size();
+		}
+		uint64 operator [] (usize index) const
+		{
+			return get()[index];
+		}
+
+		// Returns a genome private to this holder. Call seal() once the edits are done.
+		Genome &edit()
+		{
+			xassert(m_Entry != nullptr, "Empty genome reference");
+			m_Entry = GenomeStore::get().detach(m_Entry);
+			return m_Entry->Code;
+		}
+		void seal()
+		{
+			if (!m_Entry->Interned)
+			{
+				m_Entry = GenomeStore::get().intern(m_Entry);
+			}
+		}
+
+		uint64 id() const
+		{
+			return m_Entry->ID;
+		}
+		// The same for the same bytecode in every run and build, unlike id().
+		uint64 content_hash() const
+		{
+			return m_Entry->ContentHash;
+		}
+		uint32 population() const
+		{
+			return m_Entry->References.load();
+		}
+		const vector4F &color_hash() const
+		{
+			return m_Entry->ColorHash;
+		}
+		const GenomeAnalysis &analysis() const
+		{
+			xassert(m_Entry->Interned, "Only interned genomes are analyzed");
+			return m_Entry->Analysis;
+		}
+
+		const JitCode *native() const
+		{
+			return m_Entry->Native.load();
+		}
+		void record_executions(uint64 count) const
+		{
+			GenomeStore::get().record_executions(m_Entry, count);
+		}
+	};
+}
@@ -0,0 +1,87 @@
+#include "phylogen.hpp"
+#include "RegisterPool.hpp"
+
+using namespace phylo;
+using namespace phylo::VM;
+
+namespace
+{
+	struct FreeBlock final
+	{
+		FreeBlock *Next;
+	};
+
+	struct SharedState final
+	{
+		FreeBlock *Head = nullptr;
+		uint8     *SlabCursor = nullptr;
+		uint8     *SlabEnd = nullptr;
+#if XTD_DEBUG
+		atomic<bool> Busy = { false };
+#endif
+	};
+
+	// Never destroyed, like the genome arena: instances may outlive static destruction.
+	static SharedState &shared()
+	{
+		static SharedState *state = new SharedState;
+		return *state;
+	}
+
+	// Marks the pool in use for its lifetime; in debug builds, two at once means the pool was used outside the serial
+	// phases.
+	struct SerialCheck final
+	{
+#if XTD_DEBUG
+		SharedState &State;
+
+		explicit SerialCheck(SharedState &state) : State(state)
+		{
+			xassert(!State.Busy.exchange(true), "the register pool was used from two threads at once");
+		}
+		~SerialCheck()
+		{
+			State.Busy.store(false);
+		}
+#else
+		explicit SerialCheck(SharedState &) {}
+#endif
+	};
+}
+
+void *RegisterPool::allocate()
+{
+	SharedState &state = shared();
+	SerialCheck _check(state);
+
+	if (state.Head != nullptr) [[likely]]
+	{
+		FreeBlock *block = state.Head;
+		state.Head = block->Next;
+		return block;
+	}
+
+	if (state.SlabCursor == state.SlabEnd) [[unlikely]]
+	{
+		state.SlabCursor = (uint8 *)::operator new(SlabSize, std::align_val_t(BlockSize));
+		state.SlabEnd = state.SlabCursor + SlabSize;
+	}
+	void *block = state.SlabCursor;
+	state.SlabCursor += BlockSize;
+	return block;
+}
+
+void RegisterPool::deallocate(void *block)
+{
+	if (block == nullptr)
+	{
+		return;
+	}
+
+	SharedState &state = shared();
+	SerialCheck _check(state);
+
+	FreeBlock *freed = (FreeBlock *)block;
+	freed->Next = state.Head;
+	state.Head = freed;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+namespace phylo::VM
+{
+	// Storage for VM register files, kept out of the instance array so that it holds only scheduling state. Blocks are
+	// one cache line, carved from 64 KiB slabs and recycled through a free list. Instances are only created and
+	// destroyed in the serial phases of a tick, so it takes no lock; debug builds check that it is never entered twice.
+	class RegisterPool final
+	{
+	public:
+		static constexpr usize BlockSize = 64;
+		static constexpr usize SlabSize = 1ull << 16;
+
+		static void *allocate();
+		static void deallocate(void *block);
+	};
+}
@@ -0,0 +1,183 @@
+#include "phylogen.hpp"
+#include "Simulation/Simulation.hpp"
+
+using namespace phylo;
+using namespace phylo::VM;
+
+// Operands are bound exactly as Instance::execute binds them: a register operand by reference, an immediate as a
+// temporary register.
+
+template <auto Op>
+void OpcodeBuckets::run_one_param(const array<Entry> &bucket, CommandBuffer &commands)
+{
+	for (const Entry &entry : bucket)
+	{
+		Instance &vm = *entry.VM;
+		const Instance::DecodedOperation decoded = Instance::decode(entry.Operation);
+		const Instance::Register immediate1 = Instance::Register(decoded.Operand1);
+		const Instance::Register &oper1 = decoded.Operand1IsRegister ? vm.m_Registers[decoded.Operand1] : immediate1;
+		vm.end_tick((vm.*Op)(vm.m_Registers[decoded.Result], oper1), commands);
+	}
+}
+
+template <auto Op>
+void OpcodeBuckets::run_two_param(const array<Entry> &bucket, CommandBuffer &commands)
+{
+	for (const Entry &entry : bucket)
+	{
+		Instance &vm = *entry.VM;
+		const Instance::DecodedOperation decoded = Instance::decode(entry.Operation);
+		const Instance::Register immediate1 = Instance::Register(decoded.Operand1);
+		const Instance::Register immediate2 = Instance::Register(decoded.Operand2);
+		const Instance::Register &oper1 = decoded.Operand1IsRegister ? vm.m_Registers[decoded.Operand1] : immediate1;
+		const Instance::Register &oper2 = decoded.Operand2IsRegister ? vm.m_Registers[decoded.Operand2] : immediate2;
+		vm.end_tick((vm.*Op)(vm.m_Registers[decoded.Result], oper1, oper2), commands);
+	}
+}
+
+template <auto Op>
+void OpcodeBuckets::run_controller(const array<Entry> &bucket, Controller *controller, CommandBuffer &commands)
+{
+	for (const Entry &entry : bucket)
+	{
+		Instance &vm = *entry.VM;
+		const Instance::DecodedOperation decoded = Instance::decode(entry.Operation);
+		vm.end_tick((vm.*Op)(vm.m_Registers[decoded.Result], controller), commands);
+	}
+}
+
+template <auto Op>
+void OpcodeBuckets::run_command(const array<Entry> &bucket, Controller *controller, CommandBuffer &commands)
+{
+	for (const Entry &entry : bucket)
+	{
+		Instance &vm = *entry.VM;
+		const Instance::DecodedOperation decoded = Instance::decode(entry.Operation);
+		vm.end_tick((vm.*Op)(vm.m_Registers[decoded.Result], controller, commands), commands);
+	}
+}
+
+template <auto Op>
+void OpcodeBuckets::run_command_two_param(const array<Entry> &bucket, Controller *controller, CommandBuffer &commands)
+{
+	for (const Entry &entry : bucket)
+	{
+		Instance &vm = *entry.VM;
+		const Instance::DecodedOperation decoded = Instance::decode(entry.Operation);
+		const Instance::Register immediate1 = Instance::Register(decoded.Operand1);
+		const Instance::Register immediate2 = Instance::Register(decoded.Operand2);
+		const Instance::Register &oper1 = decoded.Operand1IsRegister ? vm.m_Registers[decoded.Operand1] : immediate1;
+		const Instance::Register &oper2 = decoded.Operand2IsRegister ? vm.m_Registers[decoded.Operand2] : immediate2;
+		vm.end_tick((vm.*Op)(vm.m_Registers[decoded.Result], controller, commands, oper1, oper2), commands);
+	}
+}
+
+void OpcodeBuckets::run_bucket(VM::Operation opcode, const array<Entry> &bucket, Controller *controller, CommandBuffer &commands)
+{
+	switch (opcode)
+	{
+	case VM::Operation::NOP:
+		for (const Entry &entry : bucket)
+		{
+			entry.VM->end_tick(0, commands);
+		}
+		break;
+
+	case VM::Operation::Sleep:            run_one_param<&Instance::op_Sleep>(bucket, commands); break;
+	case VM::Operation::Copy:             run_one_param<&Instance::op_Copy>(bucket, commands); break;
+	case VM::Operation::Load:             run_one_param<&Instance::op_Load>(bucket, commands); break;
+	case VM::Operation::Store:            run_one_param<&Instance::op_Store>(bucket, commands); break;
+	case VM::Operation::Load_Store:       run_one_param<&Instance::op_LoadStore>(bucket, commands); break;
+
+	case VM::Operation::Jump:             run_one_param<&Instance::op_Jump>(bucket, commands); break;
+	case VM::Operation::Jump_Z:           run_two_param<&Instance::op_JumpZ>(bucket, commands); break;
+	case VM::Operation::Jump_NZ:          run_two_param<&Instance::op_JumpNZ>(bucket, commands); break;
+	case VM::Operation::Jump_GZ:          run_two_param<&Instance::op_JumpGZ>(bucket, commands); break;
+	case VM::Operation::Jump_LZ:          run_two_param<&Instance::op_JumpLZ>(bucket, commands); break;
+	case VM::Operation::Jump_GEZ:         run_two_param<&Instance::op_JumpGEZ>(bucket, commands); break;
+	case VM::Operation::Jump_LEZ:         run_two_param<&Instance::op_JumpLEZ>(bucket, commands); break;
+
+	case VM::Operation::Add_Integer:      run_two_param<&Instance::op_Add>(bucket, commands); break;
+	case VM::Operation::Subtract_Integer: run_two_param<&Instance::op_Subtract>(bucket, commands); break;
+	case VM::Operation::Multiply_Integer: run_two_param<&Instance::op_Multiply>(bucket, commands); break;
+	case VM::Operation::Divide_Integer:   run_two_param<&Instance::op_Divide>(bucket, commands); break;
+	case VM::Operation::Modulo_Integer:   run_two_param<&Instance::op_Modulo>(bucket, commands); break;
+
+	case VM::Operation::Add_Float:        run_two_param<&Instance::op_AddF>(bucket, commands); break;
+	case VM::Operation::Subtract_Float:   run_two_param<&Instance::op_SubtractF>(bucket, commands); break;
+	case VM::Operation::Multiply_Float:   run_two_param<&Instance::op_MultiplyF>(bucket, commands); break;
+	case VM::Operation::Divide_Float:     run_two_param<&Instance::op_DivideF>(bucket, commands); break;
+	case VM::Operation::Modulo_Float:     run_two_param<&Instance::op_ModuloF>(bucket, commands); break;
+
+	case VM::Operation::LogicalAND:       run_two_param<&Instance::op_LAND>(bucket, commands); break;
+	case VM::Operation::LogicalNAND:      run_two_param<&Instance::op_LNAND>(bucket, commands); break;
+	case VM::Operation::LogicalOR:        run_two_param<&Instance::op_LOR>(bucket, commands); break;
+	case VM::Operation::LogicalNOR:       run_two_param<&Instance::op_LNOR>(bucket, commands); break;
+	case VM::Operation::LogicalNEGATE:    run_one_param<&Instance::op_LNEGATE>(bucket, commands); break;
+	case VM::Operation::LogicalXOR:       run_two_param<&Instance::op_LXOR>(bucket, commands); break;
+
+	case VM::Operation::Move:             run_one_param<&Instance::op_Move>(bucket, commands); break;
+	case VM::Operation::Rotate:           run_one_param<&Instance::op_Rotate>(bucket, commands); break;
+
+	case VM::Operation::Split:            run_command<&Instance::op_Split>(bucket, controller, commands); break;
+	case VM::Operation::Burn:             run_controller<&Instance::op_Burn>(bucket, controller, commands); break;
+	case VM::Operation::Suicide:          run_controller<&Instance::op_Suicide>(bucket, controller, commands); break;
+	case VM::Operation::Color_Green:      run_controller<&Instance::op_ColorGreen>(bucket, controller, commands); break;
+	case VM::Operation::Color_Red:        run_controller<&Instance::op_ColorRed>(bucket, controller, commands); break;
+	case VM::Operation::Color_Blue:       run_controller<&Instance::op_ColorBlue>(bucket, controller, commands); break;
+	case VM::Operation::Grow:             run_one_param<&Instance::op_Grow>(bucket, commands); break;
+	case VM::Operation::GetEnergy:        run_controller<&Instance::op_GetEnergy>(bucket, controller, commands); break;
+	case VM::Operation::GetLight_Green:   run_controller<&Instance::op_GetLightGreen>(bucket, controller, commands); break;
+	case VM::Operation::GetLight_Red:     run_controller<&Instance::op_GetLightRed>(bucket, controller, commands); break;
+	case VM::Operation::GetWaste:         run_controller<&Instance::op_GetWaste>(bucket, controller, commands); break;
+	case VM::Operation::Attack:           run_command<&Instance::op_Attack>(bucket, controller, commands); break;
+	case VM::Operation::Transfer:         run_command_two_param<&Instance::op_Transfer>(bucket, controller, commands); break;
+
+	case VM::Operation::WasTouched:       run_controller<&Instance::op_WasTouched>(bucket, controller, commands); break;
+	case VM::Operation::WasAttacked:      run_controller<&Instance::op_WasAttacked>(bucket, controller, commands); break;
+	case VM::Operation::See:              run_controller<&Instance::op_See>(bucket, controller, commands); break;
+	case VM::Operation::Size:             run_controller<&Instance::op_Size>(bucket, controller, commands); break;
+	case VM::Operation::MySize:           run_controller<&Instance::op_MySize>(bucket, controller, commands); break;
+	case VM::Operation::Armor:            run_controller<&Instance::op_Armor>(bucket, controller, commands); break;
+	case VM::Operation::MyArmor:          run_controller<&Instance::op_MyArmor>(bucket, controller, commands); break;
+	case VM::Operation::Sleep_Touch:      run_controller<&Instance::op_SleepTouched>(bucket, controller, commands); break;
+	case VM::Operation::Sleep_Attack:     run_controller<&Instance::op_SleepAttacked>(bucket, controller, commands); break;
+
+	default:
+		// Anything the interpreter does not know is a NOP there too.
+		for (const Entry &entry : bucket)
+		{
+			entry.VM->end_tick(entry.VM->execute(entry.Operation, controller, commands), commands);
+		}
+		break;
+	}
+}
+
+void OpcodeBuckets::run(Instance *instances, uint count, Controller *controller, Instance::CounterType &counter, CommandBuffer &commands)
+{
+	for (array<Entry> &bucket : m_Buckets)
+	{
+		bucket.clear();
+	}
+
+	for (uint i = 0; i < count; ++i)
+	{
+		Instance &instance = instances[i];
+		uint slot;
+		if (instance.begin_tick(counter, commands, slot))
+		{
+			const uint64 operation = instance.fetch(slot);
+			m_Buckets[Instance::decode_opcode(operation)].push_back({ &instance, operation });
+		}
+	}
+
+	for (usize opcode = 0; opcode < NumOperations; ++opcode)
+	{
+		const array<Entry> &bucket = m_Buckets[opcode];
+		if (bucket.size() != 0)
+		{
+			counter[opcode] += uint32(bucket.size());
+			run_bucket(VM::Operation(opcode), bucket, controller, commands);
+		}
+	}
+}
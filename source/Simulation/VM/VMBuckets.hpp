@@ -0,0 +1,31 @@
+#pragma once
+
+namespace phylo::VM
+{
+	// Executes a run of instances in two passes. The first does each cell's tick bookkeeping, fetches its instruction
+	// and files it under its opcode; the second runs each opcode's bucket through a loop calling that instruction's
+	// handler directly, so there is one dispatch per bucket instead of per cell and sensor instructions do their
+	// environment lookups back to back. Cells within a tick do not observe one another, so the result is the same as
+	// ticking them in order.
+	class OpcodeBuckets final
+	{
+		struct Entry final
+		{
+			Instance *VM;
+			uint64   Operation;
+		};
+
+		array<array<Entry>, NumOperations> m_Buckets;
+
+		template <auto Op> static void run_one_param(const array<Entry> &bucket, CommandBuffer &commands);
+		template <auto Op> static void run_two_param(const array<Entry> &bucket, CommandBuffer &commands);
+		template <auto Op> static void run_controller(const array<Entry> &bucket, Controller *controller, CommandBuffer &commands);
+		template <auto Op> static void run_command(const array<Entry> &bucket, Controller *controller, CommandBuffer &commands);
+		template <auto Op> static void run_command_two_param(const array<Entry> &bucket, Controller *controller, CommandBuffer &commands);
+
+		static void run_bucket(VM::Operation opcode, const array<Entry> &bucket, Controller *controller, CommandBuffer &commands);
+
+	public:
+		void run(Instance *instances, uint count, Controller *controller, Instance::CounterType &counter, CommandBuffer &commands);
+	};
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+namespace phylo
+{
+	class Cell;
+	namespace VM
+	{
+		// Deferred effects recorded by VM instructions during the parallel phase. They are plain records
+		// rather than closures so that recording them never allocates or locks; they are applied in post_update.
+
+		enum class CommandType : uint8
+		{
+			Split = 0,
+			Attack,
+			Transfer
+		};
+
+		struct SplitCmd final
+		{
+			Cell     *Parent;
+			vector2F Position;  // Where the child is placed.
+			vector2F Direction; // The child's facing.
+			uint64   Energy;    // Energy given to the child, before capacity clamping.
+			float    Radius;
+
+			// Filled in by the commit group phase, which builds the offspring from the parent's genome as of this
+			// command's place in CellID order.
+			random::source<random::engine::xorshift_plus> ChildRandom;
+			uint64   ChildID;
+			vector4F ChildDye;
+			uint32   GenomeIndex;
+			uint16   GenomeBuffer;
+#if ENABLE_TRANSLATION_TABLE
+			uint8    ChildTranslationTable[256];
+#endif
+		};
+
+		struct AttackCmd final
+		{
+			Cell *Attacker;
+			Cell *Target;
+		};
+
+		struct TransferCmd final
+		{
+			Cell   *Source;
+			Cell   *Target;
+			uint32 PayloadOffset; // Offset into the owning buffer's payload, which holds a snapshot of the transferred words.
+			uint32 PayloadSize;
+		};
+
+		// Orders every command of a tick. Index refers into the typed array of buffer 'Buffer'.
+		// TargetID is the cell whose state the command mutates: the parent for splits, the victim or recipient otherwise.
+		struct CommandKey final
+		{
+			uint64      CellID;
+			uint64      TargetID;
+			uint32      Index;
+			uint16      Buffer;
+			CommandType Type;
+		};
+		static_assert(sizeof(CommandKey) == 24, "CommandKey should pack into 24 bytes");
+
+		// One per VM worker thread, in a WorkerLocal so that workers never share a cache line while recording.
+		struct CommandBuffer final
+		{
+			array<CommandKey>  Keys;
+			array<SplitCmd>    Splits;
+			array<AttackCmd>   Attacks;
+			array<TransferCmd> Transfers;
+			array<uint64>      Payload;
+			array<GenomeRef>   Genomes; // Offspring genomes, written by the commit group phase rather than while recording.
+			array<Cell *>      Kills;
+			uint16             BufferIndex = 0;
+
+			void push(uint64 cellID, const SplitCmd &cmd)
+			{
+				Keys.push_back({ cellID, cellID, uint32(Splits.size()), BufferIndex, CommandType::Split });
+				Splits.push_back(cmd);
+			}
+
+			void push(uint64 cellID, uint64 targetID, const AttackCmd &cmd)
+			{
+				Keys.push_back({ cellID, targetID, uint32(Attacks.size()), BufferIndex, CommandType::Attack });
+				Attacks.push_back(cmd);
+			}
+
+			void push(uint64 cellID, uint64 targetID, const TransferCmd &cmd)
+			{
+				Keys.push_back({ cellID, targetID, uint32(Transfers.size()), BufferIndex, CommandType::Transfer });
+				Transfers.push_back(cmd);
+			}
+
+			void clear()
+			{
+				Keys.clear();
+				Splits.clear();
+				Attacks.clear();
+				Transfers.clear();
+				Payload.clear();
+				Genomes.clear();
+				Kills.clear();
+			}
+		};
+
+		// Stable LSD radix sort on a 64-bit key, a byte per pass. Passes where every key shares the same byte are skipped,
+		// which is the common case for the high bytes of small populations' indices.
+		template <typename T, typename KeyFunc>
+		static void radix_sort(array<T> &items, array<T> &scratch, KeyFunc &&keyFunc)
+		{
+			const usize count = items.size();
+			if (count < 2)
+			{
+				return;
+			}
+			scratch.resize(count);
+
+			T *src = items.data();
+			T *dst = scratch.data();
+
+			for (uint shift = 0; shift < 64; shift += 8)
+			{
+				usize histogram[256] = {};
+				for (usize i = 0; i < count; ++i)
+				{
+					++histogram[(keyFunc(src[i]) >> shift) & 0xFF];
+				}
+				if (histogram[(keyFunc(src[0]) >> shift) & 0xFF] == count)
+				{
+					continue;
+				}
+
+				usize offset = 0;
+				for (usize &bucket : histogram)
+				{
+					const usize bucketCount = bucket;
+					bucket = offset;
+					offset += bucketCount;
+				}
+				for (usize i = 0; i < count; ++i)
+				{
+					dst[histogram[(keyFunc(src[i]) >> shift) & 0xFF]++] = src[i];
+				}
+				std::swap(src, dst);
+			}
+
+			if (src != items.data())
+			{
+				memcpy(items.data(), src, count * sizeof(T));
+			}
+		}
+	}
+}
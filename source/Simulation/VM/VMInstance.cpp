@@ -4,9 +4,60 @@
 using namespace phylo;
 using namespace phylo::VM;
 
+namespace
+{
+	// Number of failed Bernoulli trials of the given chance before the next success, by inverting the geometric distribution.
+	template <typename TRandom>
+	static uint64 geometric_skip(TRandom &random, float chance)
+	{
+		if (chance <= 0.0f)
+		{
+			return traits<uint64>::max;
+		}
+		if (chance >= 1.0f)
+		{
+			return 0;
+		}
+
+		const double roll = double(random.uniform(0.0f, 1.0f));
+		if (roll >= 1.0)
+		{
+			return traits<uint64>::max;
+		}
+		const double skip = floor(log1p(-roll) / log1p(-double(chance)));
+		return (skip >= double(traits<uint64>::max)) ? traits<uint64>::max : uint64(skip);
+	}
+
+	// Given independent trials with the given chances, selects the first one at or after 'first' that succeeds
+	// with a single draw from their first-success distribution. Returns N if none do.
+	template <typename TRandom, usize N>
+	static uint next_success(TRandom &random, const float (&chances)[N], uint first)
+	{
+		if (first >= N)
+		{
+			return N;
+		}
+
+		const float roll = random.uniform(0.0f, 1.0f);
+		float survival = 1.0f;
+		float cumulative = 0.0f;
+		for (uint trial = first; trial < N; ++trial)
+		{
+			cumulative += survival * chances[trial];
+			if (roll < cumulative)
+			{
+				return trial;
+			}
+			survival *= 1.0f - chances[trial];
+		}
+		return N;
+	}
+}
+
 Instance::Instance()
 {
-	m_ByteCode.resize(1, 0); // Default to 8 bytes of nothingness.
+	const uint64 nothing = 0;
+	m_ByteCode.assign(&nothing, 1); // Default to 8 bytes of nothingness.
 #if ENABLE_TRANSLATION_TABLE
 	for (uint i = 0; i < 256; ++i)
 	{
@@ -17,39 +68,47 @@ Instance::Instance()
 
 void Instance::generate_bytecode_hash()
 {
-	uint32 hash_value = 0;
-	uint8 *octetsDst = (uint8 *)&hash_value;
-	for (auto codet : m_ByteCode)
-	{
-		const uint8 *octetsSrc = (const uint8 *)&codet;
-		octetsDst[0] += octetsSrc[0] + octetsSrc[3];
-		octetsDst[1] += octetsSrc[1] + octetsSrc[3];
-		octetsDst[2] += octetsSrc[2] + octetsSrc[3];
-		octetsDst[0] += octetsSrc[4] + octetsSrc[7];
-		octetsDst[1] += octetsSrc[5] + octetsSrc[7];
-		octetsDst[2] += octetsSrc[6] + octetsSrc[7];
-	}
+	m_Cell->setColorHash1(m_ByteCode.color_hash());
+}
+
+vector4F Instance::compute_bytecode_hash(const Genome &bytecode)
+{
+	// The genome keeps its byte-lane sums up to date as it is edited.
+	const uint8 *octetsDst = bytecode.color_lanes().Lanes;
 	const vector4F hsv = { (float(octetsDst[0]) / 255.5f) * 6.0f, float(octetsDst[1]) / 255.5f, float(octetsDst[2]) / 255.5f, 1.0f };
-	m_Cell->setColorHash1(hsv);
+	return hsv;
 }
 
-void Instance::mutate()
+void Instance::mutate_live()
 {
 	Cell &cell = *m_Cell;
 
-	// until we do bytecode saving, there's no reason to copy.
-	array<uint64> &bytecode = m_ByteCode;
-
 	bool mutated = false;
 
 	auto &randomGen = cell.getRandom();
 
 	Cell *cell_ptr = &cell;
-	auto mutateRoll = [&randomGen]() -> float { return randomGen.uniform(0.0f, 1.0f); };
+
+	// A live mutation is a Bernoulli trial every tick. Instead of rolling each tick, the number of ticks until the next
+	// one is drawn from the geometric distribution, so the common case is a decrement. It is redrawn if the chance changes.
+	if (m_LiveMutationChance != options::LiveMutationChance) [[unlikely]]
+	{
+		m_LiveMutationChance = options::LiveMutationChance;
+		m_TicksToMutation = geometric_skip(randomGen, m_LiveMutationChance);
+	}
+	if (m_TicksToMutation != 0) [[likely]]
+	{
+		--m_TicksToMutation;
+		return;
+	}
+	m_TicksToMutation = geometric_skip(randomGen, m_LiveMutationChance);
+
+	// The genome may be shared with relatives, so this takes a private copy unless it is the only holder.
+	Genome &bytecode = m_ByteCode.edit();
 
 	// Mutate Bytecode.
 
-	if (bytecode.size() && mutateRoll() < options::LiveMutationChance)
+	if (bytecode.size())
 	{
 		// Mutate Bytecode.
 
@@ -60,39 +119,34 @@ void Instance::mutate()
 		case 0:
 		{
 			uint8 replacement = randomGen.uniform<uint8>(0, 255); // is this range correct?
-			auto mutateOffset = randomGen.uniform_exclusive<uint>(0, bytecode.size() * sizeof(bytecode[0]));
-			array_view<uint8> mutateArray = { (uint8 *)bytecode.data(), bytecode.size_raw() };
-			mutateArray[mutateOffset] = replacement;
+			auto mutateOffset = randomGen.uniform_exclusive<uint>(0, bytecode.size() * sizeof(uint64));
+			bytecode.set_byte(mutateOffset, replacement);
 		}
 		break;
 		case 1:
 		{
-			auto mutateOffset = randomGen.uniform_exclusive<uint>(0, bytecode.size() * sizeof(bytecode[0]));
-			array_view<uint8> mutateArray = { (uint8 *)bytecode.data(), bytecode.size_raw() };
-			++mutateArray[mutateOffset];
+			auto mutateOffset = randomGen.uniform_exclusive<uint>(0, bytecode.size() * sizeof(uint64));
+			bytecode.set_byte(mutateOffset, uint8(bytecode.byte(mutateOffset) + 1));
 			break;
 		}
 		case 2:
 		{
-			auto mutateOffset = randomGen.uniform_exclusive<uint>(0, bytecode.size() * sizeof(bytecode[0]));
-			array_view<uint8> mutateArray = { (uint8 *)bytecode.data(), bytecode.size_raw() };
-			--mutateArray[mutateOffset];
+			auto mutateOffset = randomGen.uniform_exclusive<uint>(0, bytecode.size() * sizeof(uint64));
+			bytecode.set_byte(mutateOffset, uint8(bytecode.byte(mutateOffset) - 1));
 		}
 		break;
 		case 3:
 		{
 			uint8 operand = randomGen.uniform<uint8>(0, 255);
-			auto mutateOffset = randomGen.uniform_exclusive<uint>(0, bytecode.size() * sizeof(bytecode[0]));
-			array_view<uint8> mutateArray = { (uint8 *)bytecode.data(), bytecode.size_raw() };
-			mutateArray[mutateOffset] += operand;
+			auto mutateOffset = randomGen.uniform_exclusive<uint>(0, bytecode.size() * sizeof(uint64));
+			bytecode.set_byte(mutateOffset, uint8(bytecode.byte(mutateOffset) + operand));
 			break;
 		}
 		case 4:
 		{
 			uint8 operand = randomGen.uniform<uint8>(0, 255);
-			auto mutateOffset = randomGen.uniform_exclusive<uint>(0, bytecode.size() * sizeof(bytecode[0]));
-			array_view<uint8> mutateArray = { (uint8 *)bytecode.data(), bytecode.size_raw() };
-			mutateArray[mutateOffset] -= operand;
+			auto mutateOffset = randomGen.uniform_exclusive<uint>(0, bytecode.size() * sizeof(uint64));
+			bytecode.set_byte(mutateOffset, uint8(bytecode.byte(mutateOffset) - operand));
 		}
 		break;
 		case 5:
@@ -105,7 +159,7 @@ void Instance::mutate()
 		case 6:
 		{
 			auto mutateOffset = randomGen.uniform_exclusive<uint>(0, bytecode.size());
-			bytecode.erase_at(mutateOffset);
+			bytecode.erase(mutateOffset);
 		}
 		break;
 		case 7:
@@ -114,75 +168,10 @@ void Instance::mutate()
 			const usize copyMaxSize = bytecode.size() - copyOffset;
 			if (copyMaxSize > 0)
 			{
-				using bytecode_type = typename std::remove_reference<decltype(bytecode)>::type::value_type;
-				thread_local static array<bytecode_type> temp_bytecode;
 				const usize copySize = randomGen.uniform<usize>(1ull, copyMaxSize);
 				const usize mutateOffset = randomGen.uniform<usize>(0, bytecode.size());
 
-				if (mutateOffset == 0) // We are copying to the front of the bytecode.
-				{
-					const usize originalSize = bytecode.size();
-					const usize newSize = originalSize + copySize;
-
-					// enlarge bytecode array to fit the new chunk.
-					bytecode.resize(newSize);
-					// memmove the existing data in the array 'copySize' down.
-					xassert(originalSize <= newSize, "Error");
-					xassert(originalSize <= (newSize - copySize), "Error");
-					memmove(
-						bytecode.data() + copySize,
-						bytecode.data(),
-						originalSize * sizeof(bytecode_type)
-					);
-					// copy the range we are copying to the start.
-					xassert(copySize <= newSize, "Error");
-					xassert(copySize <= (newSize - (copySize + copyOffset)), "Error");
-					memcpy(
-						bytecode.data(),
-						bytecode.data() + copySize + copyOffset,
-						copySize * sizeof(bytecode_type)
-					);
-				}
-				else if (mutateOffset == bytecode.size()) // We are copying to the end of the bytecode.
-				{
-					const usize originalSize = bytecode.size();
-					const usize newSize = originalSize + copySize;
-					
-					// enlarge bytecode array to fit the new chunk.
-					bytecode.resize(newSize);
-					// Copy the range to the end.
-					xassert(copySize <= (newSize - originalSize), "Error");
-					xassert(copySize <= (newSize - copyOffset), "Error");
-					memcpy(
-						bytecode.data() + originalSize,
-						bytecode.data() + copyOffset,
-						copySize * sizeof(bytecode_type)
-					);
-				}
-				else // We are copying somewhere inside. This could be optimized.
-				{
-					const usize dataFromMutateOffset = bytecode.size() - mutateOffset;
-					// Resize the 'temp_bytecode' array for the copy.
-					temp_bytecode.resize(copySize);
-					// Copy the data into the temporary array.
-					xassert(copySize <= (bytecode.size() - copyOffset), "Error");
-					memcpy(temp_bytecode.data(), bytecode.data() + copyOffset, copySize * sizeof(bytecode_type));
-					// Enlarge the bytecode array.
-					bytecode.resize(bytecode.size() + copySize);
-
-					// Move data at the copy offset to the end of the copy range.
-					xassert(dataFromMutateOffset <= (bytecode.size() - (mutateOffset + copySize)), "Error");
-					xassert(dataFromMutateOffset <= (bytecode.size() - mutateOffset), "Error");
-					memmove(
-						bytecode.data() + mutateOffset + copySize,
-						bytecode.data() + mutateOffset,
-						dataFromMutateOffset * sizeof(bytecode_type)
-					);
-
-					// Copy the mutating data.
-					xassert(copySize <= (bytecode.size() - mutateOffset), "Error");
-					memcpy(bytecode.data() + mutateOffset, temp_bytecode.data(), copySize * sizeof(bytecode_type));
-				}
+				bytecode.insert_range(mutateOffset, bytecode, copyOffset, copySize);
 			}
 		}
 		break;
@@ -197,13 +186,9 @@ void Instance::mutate()
 		{
 			bytecode.push_back(0);
 		}
-		if (bytecode.size() >= options::MaxBytecodeSize)
-		{
-			bytecode.resize(options::MaxBytecodeSize);
-			bytecode.truncate(options::MaxBytecodeSize);
-		}
+		bytecode.truncate(options::MaxBytecodeSize);
 
-		set_bytecode_live((array<uint64> &&)bytecode);
+		bytecode_edited();
 	}
 }
 
@@ -531,7 +516,7 @@ uint64 Instance::op_Rotate(Register &resultRegister, float amount)
 	return uint64((float(options::BaseRotateCost) * amount + 1.0f) + 0.5f);
 }
 
-uint64 Instance::op_Split(Register &resultRegister, Controller *controller)
+uint64 Instance::op_Split(Register &resultRegister, Controller *controller, CommandBuffer &commands)
 {
 	Cell *cell = m_Cell;
 
@@ -625,86 +610,110 @@ uint64 Instance::op_Split(Register &resultRegister, Controller *controller)
 
 	++cell->m_NumChildren;
 
-	scoped_lock _lock(controller->m_SerializedLock);
-	controller->m_SerializedTasks += {cell->m_CellID, [=]() {
-		// Create new cell
-		Cell *pNewCell = &cell->m_Simulation.getNewCell(cell);
+	SplitCmd split;
+	split.Parent = cell;
+	split.Position = pos2;
+	split.Direction = newDirection;
+	split.Energy = halfEnergy;
+	split.Radius = newRadius;
+	commands.push(cell->m_CellID, split);
 
-		//scoped_lock _lock(controller->m_UnserializedLock); // Contention is impossible.
-		//controller->m_UnserializedTasks += [=]() {
-		   // I'm moving mutation work back to unserialized space, and using the original cells random generator.
-		   // Should be faster.
-		array<uint64> bytecode = cell->m_VMInstance->m_ByteCode;
-		{
-			auto mutateRoll = [pNewCell]() -> float { return pNewCell->getRandom().uniform(0.0f, 1.0f); };
+	resultRegister = traits<uint16>::ones;
+	return options::BaseSplitCost;
+}
 
-			if (bytecode.size() && mutateRoll() < options::MutationSubstitutionChance)
+void Instance::prepare_split(SplitCmd &command, CommandBuffer &local)
+{
+	Cell *cell = command.Parent;
+
+	// The child's RNG is seeded from the parent's stream here rather than at allocation. Nothing else draws from
+	// the parent's RNG during commit, so this is the same stream position the serial split used to see.
+	command.ChildID = Cell::draw_seed(cell, cell->m_Simulation, command.ChildRandom);
+	auto &random = command.ChildRandom;
+
+	command.GenomeBuffer = local.BufferIndex;
+	command.GenomeIndex = uint32(local.Genomes.size());
+	local.Genomes.push_back(cell->m_VMInstance->m_ByteCode);
+	GenomeRef &genome = local.Genomes.back();
+
+	// Birth mutations are independent trials with small, differing chances, so most births have none. Rather than
+	// rolling each one, a single draw selects the first pass that fires, and sampling resumes after it.
+	const float mutationChances[] = {
+		options::MutationSubstitutionChance,
+		options::MutationIncrementChance,
+		options::MutationDecrementChance,
+		options::MutationInsertionChance,
+		options::MutationDeletionChance,
+		options::MutationDuplicationChance,
+		options::MutationRangeDuplicationChance,
+		options::MutationRangeDeletionChance,
+	};
+
+	// Offspring share their parent's genome unless a birth mutation fires, in which case they get a copy of their own.
+	uint pass = next_success(random, mutationChances, 0);
+	if (pass < std::size(mutationChances))
+	{
+		Genome &bytecode = genome.edit();
+
+		for (; (pass < std::size(mutationChances)) & (bytecode.size() != 0); pass = next_success(random, mutationChances, pass + 1))
+		{
+			switch (pass)
 			{
-				uint8 replacement = pNewCell->getRandom().uniform<uint8>(0, 255); // is this range correct?
-				auto mutateOffset = pNewCell->getRandom().uniform<uint>(0, (bytecode.size() * sizeof(bytecode[0])) - 1);
-				array_view<uint8> mutateArray = { (uint8 *)bytecode.data(), bytecode.size_raw() };
-				mutateArray[mutateOffset] = replacement;
-			}
-			if (bytecode.size() && mutateRoll() < options::MutationIncrementChance)
+			case 0:
 			{
-				auto mutateOffset = pNewCell->getRandom().uniform<uint>(0, (bytecode.size() * sizeof(bytecode[0])) - 1);
-				array_view<uint8> mutateArray = { (uint8 *)bytecode.data(), bytecode.size_raw() };
-				++mutateArray[mutateOffset];
-			}
-			if (bytecode.size() && mutateRoll() < options::MutationDecrementChance)
+				uint8 replacement = random.uniform<uint8>(0, 255); // is this range correct?
+				auto mutateOffset = random.uniform<uint>(0, (bytecode.size() * sizeof(uint64)) - 1);
+				bytecode.set_byte(mutateOffset, replacement);
+			} break;
+			case 1:
 			{
-				auto mutateOffset = pNewCell->getRandom().uniform<uint>(0, (bytecode.size() * sizeof(bytecode[0])) - 1);
-				array_view<uint8> mutateArray = { (uint8 *)bytecode.data(), bytecode.size_raw() };
-				--mutateArray[mutateOffset];
-			}
-			if (bytecode.size() && mutateRoll() < options::MutationInsertionChance)
+				auto mutateOffset = random.uniform<uint>(0, (bytecode.size() * sizeof(uint64)) - 1);
+				bytecode.set_byte(mutateOffset, uint8(bytecode.byte(mutateOffset) + 1));
+			} break;
+			case 2:
+			{
+				auto mutateOffset = random.uniform<uint>(0, (bytecode.size() * sizeof(uint64)) - 1);
+				bytecode.set_byte(mutateOffset, uint8(bytecode.byte(mutateOffset) - 1));
+			} break;
+			case 3:
 			{
-				uint64 insertion = pNewCell->getRandom().uniform<uint64>(0, uint64(-1)); // is this range correct?
-				auto mutateOffset = pNewCell->getRandom().uniform<uint>(0, bytecode.size());
+				uint64 insertion = random.uniform<uint64>(0, uint64(-1)); // is this range correct?
+				auto mutateOffset = random.uniform<uint>(0, bytecode.size());
 				bytecode.insert(mutateOffset, insertion);
-			}
-			if (bytecode.size() && mutateRoll() < options::MutationDeletionChance)
+			} break;
+			case 4:
 			{
-				auto mutateOffset = pNewCell->getRandom().uniform<uint>(0, bytecode.size() - 1);
-				bytecode.erase_at(mutateOffset);
-			}
-			if (bytecode.size() && mutateRoll() < options::MutationDuplicationChance)
+				auto mutateOffset = random.uniform<uint>(0, bytecode.size() - 1);
+				bytecode.erase(mutateOffset);
+			} break;
+			case 5:
 			{
-				uint mutateSource = pNewCell->getRandom().uniform<uint>(0, bytecode.size() - 1);
-				auto mutateOffset = pNewCell->getRandom().uniform<uint>(0, bytecode.size());
+				uint mutateSource = random.uniform<uint>(0, bytecode.size() - 1);
+				auto mutateOffset = random.uniform<uint>(0, bytecode.size());
 				uint64 insertion = bytecode[mutateSource];
 				bytecode.insert(mutateOffset, insertion);
-			}
-			if (bytecode.size() && mutateRoll() < options::MutationRangeDuplicationChance)
+			} break;
+			case 6:
 			{
-				uint mutateSource = pNewCell->getRandom().uniform<uint>(0, bytecode.size() - 1);
-				auto mutateOffset = pNewCell->getRandom().uniform<uint>(0, bytecode.size());
+				uint mutateSource = random.uniform<uint>(0, bytecode.size() - 1);
+				auto mutateOffset = random.uniform<uint>(0, bytecode.size());
 
-				uint mutateSize = pNewCell->getRandom().uniform<uint>(0, bytecode.size() - 1);
+				uint mutateSize = random.uniform<uint>(0, bytecode.size() - 1);
 				mutateSize = min(mutateSize, bytecode.size() - mutateSource);
 
-				array<uint64> tempBytecode;
-				tempBytecode.reserve(mutateSize);
-				for (uint i = 0; i < mutateSize; ++i)
-				{
-					tempBytecode += bytecode[i + mutateSource];
-				}
-
-				for (uint i = 0; i < mutateSize; ++i)
-				{
-					bytecode.insert(mutateOffset + i, tempBytecode[i]);
-				}
-			}
-			if (bytecode.size() && mutateRoll() < options::MutationRangeDeletionChance)
+				// Block insert of [mutateSource, mutateSource + mutateSize) at mutateOffset.
+				bytecode.insert_range(mutateOffset, bytecode, mutateSource, mutateSize);
+			} break;
+			case 7:
 			{
-				uint mutateSource = pNewCell->getRandom().uniform<uint>(0, bytecode.size() - 1);
+				uint mutateSource = random.uniform<uint>(0, bytecode.size() - 1);
 
-				uint mutateSize = pNewCell->getRandom().uniform<uint>(0, bytecode.size() - 1);
+				uint mutateSize = random.uniform<uint>(0, bytecode.size() - 1);
 				mutateSize = min(mutateSize, bytecode.size() - mutateSource);
-				for (uint i = 0; i < mutateSize; ++i)
-				{
-					bytecode.erase_at(mutateSource);
-				}
+
+				// Block erase of [mutateSource, mutateSource + mutateSize).
+				bytecode.erase(mutateSource, mutateSize);
+			} break;
 			}
 		}
 
@@ -713,77 +722,85 @@ uint64 Instance::op_Split(Register &resultRegister, Controller *controller)
 			bytecode.push_back(0);
 		}
 
-		if (bytecode.size() >= options::MaxBytecodeSize)
-		{
-			bytecode.resize(options::MaxBytecodeSize);
-		}
+		bytecode.truncate(options::MaxBytecodeSize);
+		genome.seal();
+	}
+
+	// Slightly mutate HSV.
+	auto HSV = cell->m_ColorDye;
+	HSV.x += random.uniform<float>(-0.05f, 0.05f);
+	HSV.y += random.uniform<float>(-0.05f, 0.05f);
+	HSV.z += random.uniform<float>(-0.05f, 0.05f);
+	HSV.x = clamp(HSV.x, 0.0f, 6.0f);
+	HSV.y = clamp(HSV.y, 0.0f, 1.0f);
+	HSV.z = clamp(HSV.z, 0.0f, 1.0f);
+	command.ChildDye = HSV;
 
-		Cell &newCell = *pNewCell;
-
-		const auto cellCapacity = cell->getObjectCapacity();
-    newCell.m_GrowthPoint = cell->m_GrowthPoint;
-		*newCell.m_PhysicsInstance = *cell->m_PhysicsInstance;
-    newCell.setRadius(newRadius);
-		newCell.m_PhysicsInstance->m_Position = pos2;
-		newCell.m_PhysicsInstance->m_ShadowPosition = pos2;
-		newCell.m_PhysicsInstance->m_Direction = newDirection;
-		newCell.m_uEnergy = min(cellCapacity, halfEnergy);
-		newCell.m_ColorGreen = cell->m_ColorGreen;
-		newCell.m_ColorRed = cell->m_ColorRed;
-		newCell.m_ColorBlue = cell->m_ColorBlue;
-		newCell.setArmor(0.001f);
-		// Slightly mutate HSV.
-		auto HSV = cell->m_ColorDye;
-		HSV.x += newCell.getRandom().uniform<float>(-0.05f, 0.05f);
-		HSV.y += newCell.getRandom().uniform<float>(-0.05f, 0.05f);
-		HSV.z += newCell.getRandom().uniform<float>(-0.05f, 0.05f);
-		HSV.x = clamp(HSV.x, 0.0f, 6.0f);
-		HSV.y = clamp(HSV.y, 0.0f, 1.0f);
-		HSV.z = clamp(HSV.z, 0.0f, 1.0f);
-		newCell.m_ColorDye = HSV;
-
-		newCell.m_VMInstance->set_bytecode((array<uint64> &&)bytecode);
 #if ENABLE_TRANSLATION_TABLE
-		memcpy(newCell.m_VMInstance->OpTranslationTable, cell->m_VMInstance->OpTranslationTable, sizeof(newCell.m_VMInstance->OpTranslationTable));
+	auto mutateRoll = [&random]() -> float { return random.uniform(0.0f, 1.0f); };
 
-		// VM mutations - yes, the VM itself can mutate. Muahaha.
-		//static constexpr double CodeMutationIncrementChance = 0.01;
-		//static constexpr double CodeMutationDecrementChance = 0.01;
-		//static constexpr double CodeMutationSwapChance = 0.01;
+	uint8 *translationTable = command.ChildTranslationTable;
+	memcpy(translationTable, cell->m_VMInstance->OpTranslationTable, sizeof(command.ChildTranslationTable));
 
-		auto mutateRoll = [pNewCell]() -> float { return pNewCell->getRandom().uniform(0.0f, 1.0f); };
+	// VM mutations - yes, the VM itself can mutate. Muahaha.
+	//static constexpr double CodeMutationIncrementChance = 0.01;
+	//static constexpr double CodeMutationDecrementChance = 0.01;
+	//static constexpr double CodeMutationSwapChance = 0.01;
 
-		if (mutateRoll() < options::CodeMutationIncrementChance)
-		{
-			uint mutateIndex = pNewCell->getRandom().uniform<uint>(0, 256);
+	if (mutateRoll() < options::CodeMutationIncrementChance)
+	{
+		uint mutateIndex = random.uniform<uint>(0, 256);
 
-			++newCell.m_VMInstance->OpTranslationTable[mutateIndex];
-		}
-		if (mutateRoll() < options::CodeMutationDecrementChance)
-		{
-			uint mutateIndex = pNewCell->getRandom().uniform<uint>(0, 256);
+		++translationTable[mutateIndex];
+	}
+	if (mutateRoll() < options::CodeMutationDecrementChance)
+	{
+		uint mutateIndex = random.uniform<uint>(0, 256);
 
-			--newCell.m_VMInstance->OpTranslationTable[mutateIndex];
-		}
-		if (mutateRoll() < options::CodeMutationRandomChance)
-		{
-			uint mutateIndex = pNewCell->getRandom().uniform<uint>(0, 256);
-			uint mutateValue = pNewCell->getRandom().uniform<uint>(0, 256);
+		--translationTable[mutateIndex];
+	}
+	if (mutateRoll() < options::CodeMutationRandomChance)
+	{
+		uint mutateIndex = random.uniform<uint>(0, 256);
+		uint mutateValue = random.uniform<uint>(0, 256);
 
-			newCell.m_VMInstance->OpTranslationTable[mutateIndex] = mutateValue;
-		}
-		if (mutateRoll() < options::CodeMutationSwapChance)
-		{
-			uint mutateSrcIndex = pNewCell->getRandom().uniform<uint>(0, 256);
-			uint mutateDstIndex = pNewCell->getRandom().uniform<uint>(0, 256);
+		translationTable[mutateIndex] = mutateValue;
+	}
+	if (mutateRoll() < options::CodeMutationSwapChance)
+	{
+		uint mutateSrcIndex = random.uniform<uint>(0, 256);
+		uint mutateDstIndex = random.uniform<uint>(0, 256);
 
-			newCell.m_VMInstance->OpTranslationTable[mutateDstIndex] = newCell.m_VMInstance->OpTranslationTable[mutateSrcIndex];
-		}
+		translationTable[mutateDstIndex] = translationTable[mutateSrcIndex];
+	}
 #endif
-	}};
+}
 
-	resultRegister = traits<uint16>::ones;
-	return options::BaseSplitCost;
+void Instance::commit_split(const SplitCmd &command, GenomeRef &genome)
+{
+	Cell *cell = command.Parent;
+
+	// Create new cell
+	Cell &newCell = cell->m_Simulation.getNewCell(command.ChildRandom, command.ChildID, *cell);
+
+	const auto cellCapacity = cell->getObjectCapacity();
+	newCell.m_GrowthPoint = cell->m_GrowthPoint;
+	*newCell.m_PhysicsInstance = *cell->m_PhysicsInstance;
+	newCell.setRadius(command.Radius);
+	newCell.m_PhysicsInstance->m_Position = command.Position;
+	newCell.m_PhysicsInstance->m_ShadowPosition = command.Position;
+	newCell.m_PhysicsInstance->m_Direction = command.Direction;
+	newCell.m_uEnergy = min(cellCapacity, command.Energy);
+	newCell.m_ColorGreen = cell->m_ColorGreen;
+	newCell.m_ColorRed = cell->m_ColorRed;
+	newCell.m_ColorBlue = cell->m_ColorBlue;
+	newCell.setArmor(0.001f);
+	newCell.m_ColorDye = command.ChildDye;
+
+	newCell.m_VMInstance->adopt_bytecode(std::move(genome));
+#if ENABLE_TRANSLATION_TABLE
+	memcpy(newCell.m_VMInstance->OpTranslationTable, command.ChildTranslationTable, sizeof(command.ChildTranslationTable));
+#endif
 }
 
 uint64 Instance::op_Burn(Register &resultRegister, Controller *controller)
@@ -814,7 +831,7 @@ uint64 Instance::op_ColorGreen(Register &resultRegister, Controller *controller)
 	m_Cell->m_ColorBlue = vec.z;
 
 	resultRegister = 0_u16;
-	return 10;
+	return op_cost(VM::Operation::Color_Green);
 }
 
 uint64 Instance::op_ColorRed(Register &resultRegister, Controller *controller)
@@ -827,7 +844,7 @@ uint64 Instance::op_ColorRed(Register &resultRegister, Controller *controller)
 	m_Cell->m_ColorBlue = vec.z;
 
 	resultRegister = 0_u16;
-	return 10;
+	return op_cost(VM::Operation::Color_Red);
 }
 
 uint64 Instance::op_ColorBlue(Register &resultRegister, Controller *controller)
@@ -840,7 +857,7 @@ uint64 Instance::op_ColorBlue(Register &resultRegister, Controller *controller)
 	m_Cell->m_ColorBlue = vec.z;
 
 	resultRegister = 0_u16;
-	return 10;
+	return op_cost(VM::Operation::Color_Blue);
 }
 
 uint64 Instance::op_Grow(Register &resultRegister, float value)
@@ -990,7 +1007,7 @@ uint64 Instance::op_MyArmor(Register &resultRegister, Controller *controller)
 }
 
 
-uint64 Instance::op_Attack(Register &resultRegister, Controller *controller)
+uint64 Instance::op_Attack(Register &resultRegister, Controller *controller, CommandBuffer &commands)
 {
 	Cell *cell = m_Cell;
 
@@ -1001,25 +1018,7 @@ uint64 Instance::op_Attack(Register &resultRegister, Controller *controller)
 	if (foundCell)
 	{
 		// Now we need to attack!
-		{
-			scoped_lock _lock(controller->m_SerializedLock);
-			controller->m_SerializedTasks += {cell->m_CellID, [=]() {
-				// We attack! Every attack takes down 1/4 armor.
-				if (foundCell->getArmor() > 0.0f)
-				{
-
-					// how much armor will we take away?
-					float sizeRatio = cell->getVolume() / foundCell->getVolume();
-
-					foundCell->setArmor(max(foundCell->getArmor() - (0.9f * sizeRatio), 0.0f));
-
-					// If armor is zero, this cell is going to be killed off. This will happen elsewhere, for now we will just flag it as us having killed it.
-					// We will also do a check there to see if we die first.
-					foundCell->setKilledBy(cell);
-				}
-				++foundCell->m_AttackedRemote;
-			}};
-		}
+		commands.push(cell->m_CellID, foundCell->m_CellID, AttackCmd{ cell, foundCell });
 		resultRegister = traits<uint16>::ones;
 	}
 	else
@@ -1027,10 +1026,31 @@ uint64 Instance::op_Attack(Register &resultRegister, Controller *controller)
 		resultRegister = 0_u16;
 	}
 
-	return 2;
+	return op_cost(VM::Operation::Attack);
 }
 
-uint64 Instance::op_Transfer(Register &resultRegister, Controller *controller, int16 oper1, int16 oper2)
+void Instance::commit_attack(const AttackCmd &command)
+{
+	Cell *cell = command.Attacker;
+	Cell *foundCell = command.Target;
+
+	// We attack! Every attack takes down 1/4 armor.
+	if (foundCell->getArmor() > 0.0f)
+	{
+
+		// how much armor will we take away?
+		float sizeRatio = cell->getVolume() / foundCell->getVolume();
+
+		foundCell->setArmor(max(foundCell->getArmor() - (0.9f * sizeRatio), 0.0f));
+
+		// If armor is zero, this cell is going to be killed off. This will happen elsewhere, for now we will just flag it as us having killed it.
+		// We will also do a check there to see if we die first.
+		foundCell->setKilledBy(cell);
+	}
+	++foundCell->m_AttackedRemote;
+}
+
+uint64 Instance::op_Transfer(Register &resultRegister, Controller *controller, CommandBuffer &commands, int16 oper1, int16 oper2)
 {
 	Cell *cell = m_Cell;
 
@@ -1047,7 +1067,7 @@ uint64 Instance::op_Transfer(Register &resultRegister, Controller *controller, i
 		uint32 uoper1 = oper1;
 		uint32 uoper2 = oper2;
 
-		const auto &bytecode = m_ByteCode;
+		const Genome &bytecode = m_ByteCode.get();
 		uoper1 = min(uint32(uoper1), bytecode.size());
 		if (uoper2 == 0)
 		{
@@ -1064,43 +1084,12 @@ uint64 Instance::op_Transfer(Register &resultRegister, Controller *controller, i
 			uoper2 = bytecode.size();
 		}
 
-		{
-			scoped_lock _lock(controller->m_SerializedLock);
-			controller->m_SerializedTasks += {cell->m_CellID, [=]() {
-				// Where should we insert?
-				const auto &other_bytecode = foundCell->m_VMInstance->m_ByteCode;
-
-				const uint32 targetOffset = m_Cell->getRandom().uniform<uint32>(0, other_bytecode.size());
-
-				decltype(m_ByteCode) newBytecode;
-				usize newSize = other_bytecode.size() + uoper2;
-				newSize = min(newSize, options::MaxBytecodeSize);
-				newBytecode.reserve(newSize);
-				// This is sort of slow. Optimize later TODO.
-				usize curi = 0;
-				for (; curi < targetOffset; ++curi)
-				{
-					newBytecode.push_back(other_bytecode[curi]);
-				}
-				for (uint32 i = 0; i < uoper2; ++i)
-				{
-					if (newBytecode.size() >= newSize)
-					{
-						break;
-					}
-					newBytecode.push_back(bytecode[i + uoper1]);
-				}
-				for (; curi < other_bytecode.size(); ++curi)
-				{
-					if (newBytecode.size() >= newSize)
-					{
-						break;
-					}
-					newBytecode.push_back(other_bytecode[curi]);
-				}
-				foundCell->m_VMInstance->set_bytecode_live(newBytecode);
-			}};
-		}
+		// The transferred words are snapshotted now; the target's genome is rebuilt at commit.
+		const uint32 payloadOffset = uint32(commands.Payload.size());
+		commands.Payload.resize(payloadOffset + uoper2);
+		bytecode.copy_to(commands.Payload.data() + payloadOffset, uoper1, uoper2);
+
+		commands.push(cell->m_CellID, foundCell->m_CellID, TransferCmd{ cell, foundCell, payloadOffset, uoper2 });
 		resultRegister = traits<uint16>::ones;
 	}
 	else
@@ -1112,6 +1101,23 @@ uint64 Instance::op_Transfer(Register &resultRegister, Controller *controller, i
 	return 100;
 }
 
+void Instance::commit_transfer(const TransferCmd &command, const CommandBuffer &buffer)
+{
+	Cell *foundCell = command.Target;
+	const uint64 *payload = buffer.Payload.data() + command.PayloadOffset;
+	const uint32 payloadSize = command.PayloadSize;
+
+	// Where should we insert?
+	Genome &other_bytecode = foundCell->m_VMInstance->m_ByteCode.edit();
+
+	const uint32 targetOffset = command.Source->getRandom().uniform<uint32>(0, other_bytecode.size());
+
+	// Splicing the whole payload in and then truncating keeps the same prefix as clamping while copying did.
+	other_bytecode.insert(targetOffset, payload, payloadSize);
+	other_bytecode.truncate(options::MaxBytecodeSize);
+	foundCell->m_VMInstance->bytecode_edited();
+}
+
 uint64 Instance::op_SleepTouched(Register &resultRegister, Controller *controller)
 {
 	Cell *cell = m_Cell;
@@ -1141,6 +1147,14 @@ uint64 Instance::op_SleepAttacked(Register &resultRegister, Controller *controll
       Cost = func(resultRegister, controller);   \
       break;
 
+#define COMMAND_CASE(x, func) \
+   CASE_1R2R(x):                 \
+   CASE_1V2R(x) :                \
+   CASE_1R2V(x) :                \
+   CASE_1V2V(x) :                \
+      Cost = func(resultRegister, controller, commands);   \
+      break;
+
 #define ONE_PARAM_CASE(x, func)                                                           \
    CASE_1R2R(x) :                                                                         \
    {                                                                                      \
@@ -1177,31 +1191,152 @@ uint64 Instance::op_SleepAttacked(Register &resultRegister, Controller *controll
       Cost = func(resultRegister, (Register(uint16(opUnion.Operand1))), (Register(uint16(opUnion.Operand2))));                                                  \
    } break
 
-#define CONTROLLER_TWO_PARAM_CASE(x, func)                                                                                                                  \
+#define COMMAND_TWO_PARAM_CASE(x, func)                                                                                                                     \
    CASE_1R2R(x) :                                                                                                                                           \
    {                                                                                                                                                        \
-      Cost = func(resultRegister, controller, (m_Registers[uint(opUnion.Operand1) % m_Registers.size()]), (m_Registers[uint(opUnion.Operand2) % m_Registers.size()]));      \
+      Cost = func(resultRegister, controller, commands, (m_Registers[uint(opUnion.Operand1) % m_Registers.size()]), (m_Registers[uint(opUnion.Operand2) % m_Registers.size()]));      \
    } break;                                                                                                                                                 \
    CASE_1V2R(x) :                                                                                                                                           \
    {                                                                                                                                                        \
-      Cost = func(resultRegister, controller, (Register(uint16(opUnion.Operand1))), (m_Registers[uint(opUnion.Operand2) % m_Registers.size()]));                            \
+      Cost = func(resultRegister, controller, commands, (Register(uint16(opUnion.Operand1))), (m_Registers[uint(opUnion.Operand2) % m_Registers.size()]));                            \
    } break;                                                                                                                                                 \
    CASE_1R2V(x) :                                                                                                                                           \
    {                                                                                                                                                        \
-      Cost = func(resultRegister, controller, (m_Registers[uint(opUnion.Operand1) % m_Registers.size()]), (Register(uint16(opUnion.Operand2))));                            \
+      Cost = func(resultRegister, controller, commands, (m_Registers[uint(opUnion.Operand1) % m_Registers.size()]), (Register(uint16(opUnion.Operand2))));                            \
    } break;                                                                                                                                                 \
    CASE_1V2V(x) :                                                                                                                                           \
    {                                                                                                                                                        \
-      Cost = func(resultRegister, controller, (Register(uint16(opUnion.Operand1))), (Register(uint16(opUnion.Operand2))));                                                  \
+      Cost = func(resultRegister, controller, commands, (Register(uint16(opUnion.Operand1))), (Register(uint16(opUnion.Operand2))));                                                  \
    } break
 
-void Instance::tick(Controller *controller, CounterType &counter)
+uint64 Instance::execute(uint64 operation, Controller *controller, CommandBuffer &commands)
+{
+	// This part will only work on Little Endian systems. Need a better solution if we ever migrate to PPC.
+	Operation &opUnion = *(Operation *)&operation;
+	opUnion.OpCode = decode_opcode(operation); // otherwise evolution is VERY difficult.
+	Register &resultRegister = m_Registers[uint(opUnion.ResultRegister) % m_Registers.size()];
+	// Last two bits of the fullOpcode include type information.
+
+	static constexpr const uint16 REG1_R_REG2_R = (1 << 14) | (1 << 15);
+	static constexpr const uint16 REG1_V_REG2_R = (1 << 15);
+	static constexpr const uint16 REG1_R_REG2_V = (1 << 14);
+	static constexpr const uint16 REG1_V_REG2_V = 0;
+
+	uint64 Cost = 0;
+
+	//opUnion.OpCode = OpTranslationTable[min(opUnion.OpCode, uint64(OP_MAX))];
+	uint16 fullOpcode = operation & 0xFFFF;
+
+	switch (fullOpcode) {
+		ONE_PARAM_CASE(VM::Operation::Sleep, op_Sleep);
+
+		default:
+			switch (fullOpcode)
+			{
+			default:
+				CASE_1R2R(VM::Operation::NOP) :
+				CASE_1V2R(VM::Operation::NOP) :
+				CASE_1R2V(VM::Operation::NOP) :
+				CASE_1V2V(VM::Operation::NOP) :
+					// Do nothing!
+					break;
+
+				ONE_PARAM_CASE(VM::Operation::Copy, op_Copy);
+				ONE_PARAM_CASE(VM::Operation::Load, op_Load);
+				ONE_PARAM_CASE(VM::Operation::Store, op_Store);
+				ONE_PARAM_CASE(VM::Operation::Load_Store, op_LoadStore);
+
+				ONE_PARAM_CASE(VM::Operation::Jump, op_Jump);
+				TWO_PARAM_CASE(VM::Operation::Jump_Z, op_JumpZ);
+				TWO_PARAM_CASE(VM::Operation::Jump_NZ, op_JumpNZ);
+				TWO_PARAM_CASE(VM::Operation::Jump_GZ, op_JumpGZ);
+				TWO_PARAM_CASE(VM::Operation::Jump_LZ, op_JumpLZ);
+				TWO_PARAM_CASE(VM::Operation::Jump_GEZ, op_JumpGEZ);
+				TWO_PARAM_CASE(VM::Operation::Jump_LEZ, op_JumpLEZ);
+
+				TWO_PARAM_CASE(VM::Operation::Add_Integer, op_Add);
+				TWO_PARAM_CASE(VM::Operation::Subtract_Integer, op_Subtract);
+				TWO_PARAM_CASE(VM::Operation::Multiply_Integer, op_Multiply);
+				TWO_PARAM_CASE(VM::Operation::Divide_Integer, op_Divide);
+				TWO_PARAM_CASE(VM::Operation::Modulo_Integer, op_Modulo);
+
+				TWO_PARAM_CASE(VM::Operation::Add_Float, op_AddF);
+				TWO_PARAM_CASE(VM::Operation::Subtract_Float, op_SubtractF);
+				TWO_PARAM_CASE(VM::Operation::Multiply_Float, op_MultiplyF);
+				TWO_PARAM_CASE(VM::Operation::Divide_Float, op_DivideF);
+				TWO_PARAM_CASE(VM::Operation::Modulo_Float, op_ModuloF);
+
+				TWO_PARAM_CASE(VM::Operation::LogicalAND, op_LAND);
+				TWO_PARAM_CASE(VM::Operation::LogicalNAND, op_LNAND);
+				TWO_PARAM_CASE(VM::Operation::LogicalOR, op_LOR);
+				TWO_PARAM_CASE(VM::Operation::LogicalNOR, op_LNOR);
+				ONE_PARAM_CASE(VM::Operation::LogicalNEGATE, op_LNEGATE);
+				TWO_PARAM_CASE(VM::Operation::LogicalXOR, op_LXOR);
+
+				ONE_PARAM_CASE(VM::Operation::Move, op_Move);
+				ONE_PARAM_CASE(VM::Operation::Rotate, op_Rotate);
+
+				COMMAND_CASE(VM::Operation::Split, op_Split);
+				CONTROLLER_CASE(VM::Operation::Burn, op_Burn);
+				CONTROLLER_CASE(VM::Operation::Suicide, op_Suicide);
+				CONTROLLER_CASE(VM::Operation::Color_Green, op_ColorGreen);
+				CONTROLLER_CASE(VM::Operation::Color_Red, op_ColorRed);
+				CONTROLLER_CASE(VM::Operation::Color_Blue, op_ColorBlue);
+				ONE_PARAM_CASE(VM::Operation::Grow, op_Grow);
+				CONTROLLER_CASE(VM::Operation::GetEnergy, op_GetEnergy);
+				CONTROLLER_CASE(VM::Operation::GetLight_Green, op_GetLightGreen);
+				CONTROLLER_CASE(VM::Operation::GetLight_Red, op_GetLightRed);
+				CONTROLLER_CASE(VM::Operation::GetWaste, op_GetWaste);
+				COMMAND_CASE(VM::Operation::Attack, op_Attack);
+				COMMAND_TWO_PARAM_CASE(VM::Operation::Transfer, op_Transfer);
+
+				CONTROLLER_CASE(VM::Operation::WasTouched, op_WasTouched);
+				CONTROLLER_CASE(VM::Operation::WasAttacked, op_WasAttacked);
+				CONTROLLER_CASE(VM::Operation::See, op_See);
+				CONTROLLER_CASE(VM::Operation::Size, op_Size);
+				CONTROLLER_CASE(VM::Operation::MySize, op_MySize);
+				CONTROLLER_CASE(VM::Operation::Armor, op_Armor);
+				CONTROLLER_CASE(VM::Operation::MyArmor, op_MyArmor);
+				CONTROLLER_CASE(VM::Operation::Sleep_Touch, op_SleepTouched);
+				CONTROLLER_CASE(VM::Operation::Sleep_Attack, op_SleepAttacked);
+			}
+			break;
+	}
+
+	xassert((op_cost(VM::Operation(opUnion.OpCode)) == GenomeAnalysis::DynamicCost) || (Cost == op_cost(VM::Operation(opUnion.OpCode))), "An instruction charged other than its op_cost()");
+	return Cost;
+}
+
+uint64 Instance::verify_native(const JitCode &native, uint slot, JitCode::Frame &frame, Controller *controller, CommandBuffer &commands)
+{
+	// Inline blocks touch nothing but the registers and the program counter, so both tiers can run the same slot from
+	// the same state. The interpreter's result is the one kept.
+	const RegisterArray registers = m_Registers.get();
+	const uint programCounter = m_ProgramCounter;
+
+	const uint64 nativeCost = native.run(slot, frame);
+	const RegisterArray nativeRegisters = m_Registers.get();
+	const uint nativeProgramCounter = m_ProgramCounter;
+
+	m_Registers.get() = registers;
+	m_ProgramCounter = programCounter;
+	const uint64 Cost = execute(m_ByteCode[slot], controller, commands);
+
+	if ((Cost != nativeCost) | (m_ProgramCounter != nativeProgramCounter) | (memcmp(m_Registers.data(), nativeRegisters.data(), sizeof(registers)) != 0)) [[unlikely]]
+	{
+		JitCode::report_mismatch();
+		xassert(false, "Native code diverged from the interpreter");
+	}
+	return Cost;
+}
+
+bool Instance::begin_tick(CounterType &counter, CommandBuffer &commands, uint &slot)
 {
 	Cell * __restrict cell = m_Cell;
 
 	if (!cell->m_Alive) [[unlikely]]
 	{
-		return;
+		return false;
 	}
 
 	bool sleep = false;
@@ -1255,11 +1390,10 @@ void Instance::tick(Controller *controller, CounterType &counter)
 		if (cell->m_uEnergy == 0)
 		{
 			// Kill the cell.
-			scoped_lock _lock(controller->m_SerializedLock);
-			controller->m_KillTasks += cell;
+			commands.Kills += cell;
 		}
 
-		return;
+		return false;
 	}
 
 	uint64 energyCost = uint64(options::TickEnergyLost * costMultiplier); // This is the base cost presuming a volume of '1.0'. As cells get larger,
@@ -1271,18 +1405,18 @@ void Instance::tick(Controller *controller, CounterType &counter)
 	if (cell->m_uEnergy == 0u)
 	{
 		// Kill the cell.
-		scoped_lock _lock(controller->m_SerializedLock);
-		controller->m_KillTasks += cell;
-		return;
+		commands.Kills += cell;
+		return false;
 	}
 
 	// We execute one instruction here.
-	xassert(m_ProgramCounter <= m_ByteCode.size(), "How did the PC go past bytecode end?");
-	uint programCounter = m_ProgramCounter;
-	++m_ProgramCounter;
-	m_ProgramCounter %= m_ByteCode.size();
+	slot = next_slot();
+	return true;
+}
 
-	uint64 operation = m_ByteCode[programCounter];
+uint64 Instance::fetch(uint slot) const
+{
+	uint64 operation = m_ByteCode[slot];
 
 #if ENABLE_TRANSLATION_TABLE
 	// handle table transformation.
@@ -1293,100 +1427,47 @@ void Instance::tick(Controller *controller, CounterType &counter)
 	}
 #endif
 
-	// This part will only work on Little Endian systems. Need a better solution if we ever migrate to PPC.
-	Operation &opUnion = *(Operation *)&operation;
-	opUnion.OpCode %= uint16(VM::Operation::MaximumCount); // otherwise evolution is VERY difficult.
-	Register &resultRegister = m_Registers[uint(opUnion.ResultRegister) % m_Registers.size()];
-	// Last two bits of the fullOpcode include type information.
-
-	static constexpr const uint16 REG1_R_REG2_R = (1 << 14) | (1 << 15);
-	static constexpr const uint16 REG1_V_REG2_R = (1 << 15);
-	static constexpr const uint16 REG1_R_REG2_V = (1 << 14);
-	static constexpr const uint16 REG1_V_REG2_V = 0;
-
-	uint64 Cost = 0;
-
-	//opUnion.OpCode = OpTranslationTable[min(opUnion.OpCode, uint64(OP_MAX))];
-	uint16 fullOpcode = operation & 0xFFFF;
-
-	uint16 opcodeForTracking = min(uint16(opUnion.OpCode), uint16(VM::Operation::MaximumCount));
-	++counter[opcodeForTracking];
-
-	switch (fullOpcode) {
-		ONE_PARAM_CASE(VM::Operation::Sleep, op_Sleep);
-
-		default:
-			switch (fullOpcode)
-			{
-			default:
-				CASE_1R2R(VM::Operation::NOP) :
-				CASE_1V2R(VM::Operation::NOP) :
-				CASE_1R2V(VM::Operation::NOP) :
-				CASE_1V2V(VM::Operation::NOP) :
-					// Do nothing!
-					break;
-
-				ONE_PARAM_CASE(VM::Operation::Copy, op_Copy);
-				ONE_PARAM_CASE(VM::Operation::Load, op_Load);
-				ONE_PARAM_CASE(VM::Operation::Store, op_Store);
-				ONE_PARAM_CASE(VM::Operation::Load_Store, op_LoadStore);
-
-				ONE_PARAM_CASE(VM::Operation::Jump, op_Jump);
-				TWO_PARAM_CASE(VM::Operation::Jump_Z, op_JumpZ);
-				TWO_PARAM_CASE(VM::Operation::Jump_NZ, op_JumpNZ);
-				TWO_PARAM_CASE(VM::Operation::Jump_GZ, op_JumpGZ);
-				TWO_PARAM_CASE(VM::Operation::Jump_LZ, op_JumpLZ);
-				TWO_PARAM_CASE(VM::Operation::Jump_GEZ, op_JumpGEZ);
-				TWO_PARAM_CASE(VM::Operation::Jump_LEZ, op_JumpLEZ);
+	return operation;
+}
 
-				TWO_PARAM_CASE(VM::Operation::Add_Integer, op_Add);
-				TWO_PARAM_CASE(VM::Operation::Subtract_Integer, op_Subtract);
-				TWO_PARAM_CASE(VM::Operation::Multiply_Integer, op_Multiply);
-				TWO_PARAM_CASE(VM::Operation::Divide_Integer, op_Divide);
-				TWO_PARAM_CASE(VM::Operation::Modulo_Integer, op_Modulo);
+uint64 Instance::run_slot(uint slot, Controller *controller, CounterType &counter, CommandBuffer &commands)
+{
+	uint64 Cost;
 
-				TWO_PARAM_CASE(VM::Operation::Add_Float, op_AddF);
-				TWO_PARAM_CASE(VM::Operation::Subtract_Float, op_SubtractF);
-				TWO_PARAM_CASE(VM::Operation::Multiply_Float, op_MultiplyF);
-				TWO_PARAM_CASE(VM::Operation::Divide_Float, op_DivideF);
-				TWO_PARAM_CASE(VM::Operation::Modulo_Float, op_ModuloF);
+	const JitCode *native = options::NativeTier ? m_ByteCode.native() : nullptr;
+	if (native)
+	{
+		++counter[native->opcode(slot)];
 
-				TWO_PARAM_CASE(VM::Operation::LogicalAND, op_LAND);
-				TWO_PARAM_CASE(VM::Operation::LogicalNAND, op_LNAND);
-				TWO_PARAM_CASE(VM::Operation::LogicalOR, op_LOR);
-				TWO_PARAM_CASE(VM::Operation::LogicalNOR, op_LNOR);
-				ONE_PARAM_CASE(VM::Operation::LogicalNEGATE, op_LNEGATE);
-				TWO_PARAM_CASE(VM::Operation::LogicalXOR, op_LXOR);
+		JitCode::Frame frame = { this, controller, &commands, (uint16 *)m_Registers.data(), &m_ProgramCounter };
+		if (options::NativeTierVerify && native->is_inline(slot)) [[unlikely]]
+		{
+			Cost = verify_native(*native, slot, frame, controller, commands);
+		}
+		else
+		{
+			Cost = native->run(slot, frame);
+		}
+	}
+	else
+	{
+		const uint64 operation = fetch(slot);
+		++counter[decode_opcode(operation)];
+		Cost = execute(operation, controller, commands);
 
-				ONE_PARAM_CASE(VM::Operation::Move, op_Move);
-				ONE_PARAM_CASE(VM::Operation::Rotate, op_Rotate);
+		if (options::NativeTier && (++m_NativeTierTicks == JitCode::SampleInterval)) [[unlikely]]
+		{
+			m_NativeTierTicks = 0;
+			m_ByteCode.record_executions(JitCode::SampleInterval);
+		}
+	}
 
-				CONTROLLER_CASE(VM::Operation::Split, op_Split);
-				CONTROLLER_CASE(VM::Operation::Burn, op_Burn);
-				CONTROLLER_CASE(VM::Operation::Suicide, op_Suicide);
-				CONTROLLER_CASE(VM::Operation::Color_Green, op_ColorGreen);
-				CONTROLLER_CASE(VM::Operation::Color_Red, op_ColorRed);
-				CONTROLLER_CASE(VM::Operation::Color_Blue, op_ColorBlue);
-				ONE_PARAM_CASE(VM::Operation::Grow, op_Grow);
-				CONTROLLER_CASE(VM::Operation::GetEnergy, op_GetEnergy);
-				CONTROLLER_CASE(VM::Operation::GetLight_Green, op_GetLightGreen);
-				CONTROLLER_CASE(VM::Operation::GetLight_Red, op_GetLightRed);
-				CONTROLLER_CASE(VM::Operation::GetWaste, op_GetWaste);
-				CONTROLLER_CASE(VM::Operation::Attack, op_Attack);
-				CONTROLLER_TWO_PARAM_CASE(VM::Operation::Transfer, op_Transfer);
+	return Cost;
+}
 
-				CONTROLLER_CASE(VM::Operation::WasTouched, op_WasTouched);
-				CONTROLLER_CASE(VM::Operation::WasAttacked, op_WasAttacked);
-				CONTROLLER_CASE(VM::Operation::See, op_See);
-				CONTROLLER_CASE(VM::Operation::Size, op_Size);
-				CONTROLLER_CASE(VM::Operation::MySize, op_MySize);
-				CONTROLLER_CASE(VM::Operation::Armor, op_Armor);
-				CONTROLLER_CASE(VM::Operation::MyArmor, op_MyArmor);
-				CONTROLLER_CASE(VM::Operation::Sleep_Touch, op_SleepTouched);
-				CONTROLLER_CASE(VM::Operation::Sleep_Attack, op_SleepAttacked);
-			}
-			break;
-	}
+void Instance::end_tick(uint64 Cost, CommandBuffer &commands)
+{
+	Cell * __restrict cell = m_Cell;
 
 	if (Cost != 0)
 	{
@@ -1400,15 +1481,71 @@ void Instance::tick(Controller *controller, CounterType &counter)
 	if ((cell->m_uEnergy == 0u) | (Cost == uint16(-1)))
 	{
 		// Kill the cell.
-		scoped_lock _lock(controller->m_SerializedLock);
-		controller->m_KillTasks += cell;
+		commands.Kills += cell;
+	}
+}
+
+template <bool Profiled>
+void Instance::tick(Controller *controller, CounterType &counter, CommandBuffer &commands, Profiler *profiler)
+{
+	uint slot;
+	if (!begin_tick(counter, commands, slot))
+	{
+		return;
 	}
 
+	auto run = [&](uint index) -> uint64
+	{
+		if constexpr (Profiled)
+		{
+			if (profiler->should_sample()) [[unlikely]]
+			{
+				const uint16 opcode = decode_opcode(fetch(index));
+				const uint64 start = Profiler::timestamp();
+				const uint64 Cost = run_slot(index, controller, counter, commands);
+				profiler->record(opcode, m_ByteCode.content_hash(), index, Profiler::timestamp() - start);
+				return Cost;
+			}
+		}
+		return run_slot(index, controller, counter, commands);
+	};
+
+	uint64 Cost = run(slot);
+
+	// With more than one instruction per tick, execution continues for as long as it stays within the registers; the
+	// first instruction to act on the cell or the world is the tick's last. The tick's respiration and sleep checks
+	// are paid once for the whole run, and the run's costs are charged together.
+	//
+	// What each slot is comes from the genome's analysis rather than decoding it again. Every instruction of a
+	// straight-line run may be followed by the next, so the run and the instruction after it go without another
+	// look; a jump within the registers lets just its successor through.
+	const GenomeAnalysis &analysis = m_ByteCode.analysis();
+	uint remaining = uint(max(options::InstructionsPerTick, 1)) - 1;
+	while (remaining > 0)
+	{
+		const GenomeAnalysis::Slot &info = analysis.Slots[slot];
+		if (!(info.Flags & GenomeAnalysis::RegisterOnly))
+		{
+			break;
+		}
+		uint count = min(max(uint(info.PureRun), 1u), remaining);
+		remaining -= count;
+		for (; count > 0; --count)
+		{
+			slot = next_slot();
+			Cost += run(slot);
+		}
+	}
+
+	end_tick(Cost, commands);
 }
 
+template void Instance::tick<false>(Controller *controller, CounterType &counter, CommandBuffer &commands, Profiler *profiler);
+template void Instance::tick<true>(Controller *controller, CounterType &counter, CommandBuffer &commands, Profiler *profiler);
+
 void Instance::unserialize(Stream &inStream, Cell *cell)
 {
-	inStream.read(m_Registers);
+	inStream.read(m_Registers.get());
 	inStream.read(m_ProgramCounter);
 #if ENABLE_TRANSLATION_TABLE
 	inStream.read(OpTranslationTable);
@@ -1417,19 +1554,24 @@ void Instance::unserialize(Stream &inStream, Cell *cell)
 	inStream.read(m_SleepCount);
 	xtd::array<uint64>::size_type bytecodeLen = 0;
 	inStream.read(bytecodeLen);
-	m_ByteCode.resize(bytecodeLen);
-	inStream.readRaw(m_ByteCode.data(), m_ByteCode.size_raw());
+	thread_local static array<uint64> bytecode;
+	bytecode.resize(bytecodeLen);
+	inStream.readRaw(bytecode.data(), bytecode.size_raw());
+	m_ByteCode.assign(bytecode.data(), bytecode.size());
 }
 
 void Instance::serialize(Stream &outStream) const
 {
-	outStream.write(m_Registers);
+	outStream.write(m_Registers.get());
 	outStream.write(m_ProgramCounter);
 #if ENABLE_TRANSLATION_TABLE
 	outStream.write(OpTranslationTable);
 #endif
 	outStream.write(m_SleepState);
 	outStream.write(m_SleepCount);
-	outStream.write(m_ByteCode.size());
-	outStream.writeRaw(m_ByteCode.data(), m_ByteCode.size_raw());
+	outStream.write(xtd::array<uint64>::size_type(m_ByteCode.size()));
+	m_ByteCode.get().for_each_span([&outStream](const uint64 *words, usize count)
+	{
+		outStream.writeRaw(words, count * sizeof(uint64));
+	});
 }
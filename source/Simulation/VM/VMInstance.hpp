@@ -4,6 +4,11 @@
 
 #include "VMControllerAlias.hpp"
 #include "VMInstructions.hpp"
+#include "GenomeStore.hpp"
+#include "RegisterPool.hpp"
+#include "VMJit.hpp"
+#include "VMProfiler.hpp"
+#include "VMCommands.hpp"
 
 namespace phylo
 {
@@ -56,10 +61,69 @@ namespace phylo
 			};
 
 			static constexpr uint16			NumRegisters = 32;
+			using RegisterArray = array<Register, NumRegisters>;
+			static_assert(sizeof(RegisterArray) == RegisterPool::BlockSize, "A register file must fill a pool block");
 
-			array<Register, NumRegisters>	m_Registers; // 16-bit registers.
-			Cell *m_Cell = nullptr;
-			uint                            m_ProgramCounter = 0;
+			// Owns a register file in the RegisterPool. Moving an instance, as removal does, only moves the pointer.
+			class RegisterFile final
+			{
+				RegisterArray *m_File;
+
+			public:
+				RegisterFile() : m_File(new (RegisterPool::allocate()) RegisterArray()) {}
+				RegisterFile(const RegisterFile &other) : m_File(new (RegisterPool::allocate()) RegisterArray(*other.m_File)) {}
+				RegisterFile(RegisterFile &&other) noexcept : m_File(other.m_File)
+				{
+					other.m_File = nullptr;
+				}
+				~RegisterFile()
+				{
+					RegisterPool::deallocate(m_File);
+				}
+
+				RegisterFile &operator = (const RegisterFile &other)
+				{
+					// A moved-from file has given its block away.
+					if (m_File == nullptr)
+					{
+						m_File = new (RegisterPool::allocate()) RegisterArray(*other.m_File);
+					}
+					else
+					{
+						*m_File = *other.m_File;
+					}
+					return *this;
+				}
+				RegisterFile &operator = (RegisterFile &&other) noexcept
+				{
+					std::swap(m_File, other.m_File);
+					return *this;
+				}
+
+				Register &operator [] (usize index) { return (*m_File)[index]; }
+				const Register &operator [] (usize index) const { return (*m_File)[index]; }
+				static constexpr usize size() { return NumRegisters; }
+				Register *data() { return m_File->data(); }
+				const Register *data() const { return m_File->data(); }
+				RegisterArray &get() { return *m_File; }
+				const RegisterArray &get() const { return *m_File; }
+			};
+
+			enum class SleepState
+			{
+				None = 0,
+				Touched,
+				Attacked
+			};
+
+			// Scheduling state, which every tick reads whether or not the cell executes. It is kept together at the
+			// front of the instance; registers and the rarely used fields follow.
+			Cell                     *m_Cell = nullptr;
+			uint                     m_ProgramCounter = 0;
+			SleepState               m_SleepState = SleepState::None;
+			uint64                   m_SleepCount = 0;
+			GenomeRef                m_ByteCode; // Shared with every other cell running the same bytecode. It will always be at least 8 bytes.
+			RegisterFile             m_Registers; // 16-bit registers, only touched by cells that execute.
 
 			Instance();
 
@@ -79,6 +143,99 @@ namespace phylo
 
 			using CounterType = array<uint32, NumOperations + 1>;
 
+			// The opcode an instruction word executes as.
+			static uint16 decode_opcode(uint64 operation)
+			{
+				return uint16((operation & 0x3FFF) % uint64(VM::Operation::MaximumCount));
+			}
+
+			// Whether an opcode only reads and writes the registers and program counter. Any number of these may run in
+			// one tick; anything touching the cell, the world or the sleep state ends it.
+			static bool is_register_op(uint16 opcode)
+			{
+				switch (VM::Operation(opcode))
+				{
+				case VM::Operation::NOP:
+				case VM::Operation::Copy:
+				case VM::Operation::Load:
+				case VM::Operation::Store:
+				case VM::Operation::Load_Store:
+				case VM::Operation::Add_Integer:
+				case VM::Operation::Subtract_Integer:
+				case VM::Operation::Multiply_Integer:
+				case VM::Operation::Divide_Integer:
+				case VM::Operation::Modulo_Integer:
+				case VM::Operation::Add_Float:
+				case VM::Operation::Subtract_Float:
+				case VM::Operation::Multiply_Float:
+				case VM::Operation::Divide_Float:
+				case VM::Operation::Modulo_Float:
+				case VM::Operation::LogicalAND:
+				case VM::Operation::LogicalNAND:
+				case VM::Operation::LogicalOR:
+				case VM::Operation::LogicalNOR:
+				case VM::Operation::LogicalNEGATE:
+				case VM::Operation::LogicalXOR:
+				case VM::Operation::Jump:
+				case VM::Operation::Jump_Z:
+				case VM::Operation::Jump_NZ:
+				case VM::Operation::Jump_GZ:
+				case VM::Operation::Jump_LZ:
+				case VM::Operation::Jump_GEZ:
+				case VM::Operation::Jump_LEZ:
+					return true;
+				default:
+					return false;
+				}
+			}
+
+			// The energy an instruction costs, before scaling by volume, where that depends on neither its operands, the
+			// cell nor the options; GenomeAnalysis::DynamicCost where it does. The op_* functions return these, and
+			// execute() checks that they do, so the analysis's cost table is the interpreter's.
+			static constexpr uint8 op_cost(VM::Operation opcode)
+			{
+				switch (opcode)
+				{
+				case VM::Operation::Color_Green:
+				case VM::Operation::Color_Red:
+				case VM::Operation::Color_Blue:
+					return 10;
+				case VM::Operation::Attack:
+					return 2;
+				case VM::Operation::Rotate:   // Scales with the amount and BaseRotateCost.
+				case VM::Operation::Split:    // BaseSplitCost.
+				case VM::Operation::Transfer: // Free when there is no target.
+					return GenomeAnalysis::DynamicCost;
+				default:
+					return 0;
+				}
+			}
+
+			// An instruction word with its register indices reduced, as execute() sees it.
+			struct DecodedOperation final
+			{
+				VM::Operation Opcode;
+				uint16        Result;   // Register index.
+				uint16        Operand1; // Register index when Operand1IsRegister, otherwise the immediate.
+				uint16        Operand2;
+				bool          Operand1IsRegister;
+				bool          Operand2IsRegister;
+			};
+			static DecodedOperation decode(uint64 operation)
+			{
+				const Operation &opUnion = *(const Operation *)&operation;
+				const bool operand1IsRegister = (operation & (1 << 14)) != 0;
+				const bool operand2IsRegister = (operation & (1 << 15)) != 0;
+				return {
+					VM::Operation(decode_opcode(operation)),
+					uint16(uint(opUnion.ResultRegister) % NumRegisters),
+					operand1IsRegister ? uint16(uint(opUnion.Operand1) % NumRegisters) : uint16(opUnion.Operand1),
+					operand2IsRegister ? uint16(uint(opUnion.Operand2) % NumRegisters) : uint16(opUnion.Operand2),
+					operand1IsRegister,
+					operand2IsRegister
+				};
+			}
+
 #define _VM_STRINGVIEWCASE(x) case x: return #x;
 
 			static string_view getInstructionName(uint16 instruction)
@@ -209,38 +366,68 @@ namespace phylo
 			uint8 OpTranslationTable[256];
 #endif
 
-			enum class SleepState
-			{
-				None = 0,
-				Touched,
-				Attacked
-			} m_SleepState = SleepState::None;
-			uint64                   m_SleepCount = 0;
-			array<uint64>            m_ByteCode; // This is aligned to 64 bits. Actual size is below. It will always be at least 8 bytes.
+			uint64                   m_TicksToMutation = 0;        // Ticks left before the next live mutation.
+			float                    m_LiveMutationChance = -1.0f; // The chance m_TicksToMutation was drawn with.
+			uint32                   m_NativeTierTicks = 0;        // Executions not yet added to the genome's native tier tally.
 
 			void generate_bytecode_hash();
+			static vector4F compute_bytecode_hash(const Genome &bytecode);
 
 			void set_bytecode(const array_view<uint64> &bytecode)
 			{
 				xassert(m_ProgramCounter == 0, "Cannot set the bytecode of an active VM");
-				m_ByteCode = bytecode;
+				m_ByteCode.assign(bytecode.data(), bytecode.size());
+				generate_bytecode_hash();
+			}
+			// Called after editing the genome returned by m_ByteCode.edit() on a live VM.
+			void bytecode_edited()
+			{
+				m_ByteCode.seal();
+				m_ProgramCounter %= m_ByteCode.size();
 				generate_bytecode_hash();
 			}
-			void set_bytecode(array_view<uint64> &&bytecode)
+			// Takes over a genome reference built elsewhere.
+			void adopt_bytecode(GenomeRef &&bytecode)
 			{
 				xassert(m_ProgramCounter == 0, "Cannot set the bytecode of an active VM");
-				m_ByteCode = bytecode;
+				m_ByteCode = std::move(bytecode);
 				generate_bytecode_hash();
 			}
-			void set_bytecode_live(array_view<uint64> &&bytecode)
+			// With Profiled set, instructions are sampled into the profiler; otherwise it is unused and may be null.
+			template <bool Profiled>
+			void tick(Controller *controller, CounterType &counter, CommandBuffer &commands, Profiler *profiler);
+			// The stages of tick(), for executors that batch the instruction itself across cells. begin_tick handles
+			// sleeping and the tick's energy cost and returns the slot to execute, if any; end_tick charges the
+			// instruction's Cost.
+			bool begin_tick(CounterType &counter, CommandBuffer &commands, uint &slot);
+			// Returns the slot at the program counter and advances past it.
+			uint next_slot()
 			{
-				m_ByteCode = bytecode;
+				xassert(m_ProgramCounter <= m_ByteCode.size(), "How did the PC go past bytecode end?");
+				const uint slot = m_ProgramCounter;
+				++m_ProgramCounter;
 				m_ProgramCounter %= m_ByteCode.size();
-				generate_bytecode_hash();
+				return slot;
 			}
-			void tick(Controller *controller, CounterType &counter);
-
-			void mutate();
+			// The instruction word at a slot, after translation.
+			uint64 fetch(uint slot) const;
+			uint64 run_slot(uint slot, Controller *controller, CounterType &counter, CommandBuffer &commands);
+			void end_tick(uint64 Cost, CommandBuffer &commands);
+			// Decodes and executes a single instruction word, returning its Cost. Shared by the interpreter and native code.
+			uint64 execute(uint64 operation, Controller *controller, CommandBuffer &commands);
+			uint64 verify_native(const JitCode &native, uint slot, JitCode::Frame &frame, Controller *controller, CommandBuffer &commands);
+
+			void mutate()
+			{
+				// The common case is just counting down to the next live mutation.
+				if ((m_TicksToMutation != 0) & (m_LiveMutationChance == options::LiveMutationChance)) [[likely]]
+				{
+					--m_TicksToMutation;
+					return;
+				}
+				mutate_live();
+			}
+			void mutate_live();
 
 			// VM instructions
 			uint64 op_Sleep(Register &resultRegister, uint16 ticks);
@@ -279,7 +466,7 @@ namespace phylo
 			uint64 op_JumpLZ(Register &resultRegister, int16 amount, int16 value);
 			uint64 op_JumpGEZ(Register &resultRegister, int16 amount, int16 value);
 			uint64 op_JumpLEZ(Register &resultRegister, int16 amount, int16 value);
-			uint64 op_Split(Register &resultRegister, Controller *controller);
+			uint64 op_Split(Register &resultRegister, Controller *controller, CommandBuffer &commands);
 			uint64 op_Burn(Register &resultRegister, Controller *controller);
 			uint64 op_Suicide(Register &resultRegister, Controller *controller);
 			uint64 op_ColorGreen(Register &resultRegister, Controller *controller);
@@ -299,9 +486,17 @@ namespace phylo
 			uint64 op_Armor(Register &resultRegister, Controller *controller);
 			uint64 op_MyArmor(Register &resultRegister, Controller *controller);
 
-			uint64 op_Attack(Register &resultRegister, Controller *controller);
+			uint64 op_Attack(Register &resultRegister, Controller *controller, CommandBuffer &commands);
+
+			uint64 op_Transfer(Register &resultRegister, Controller *controller, CommandBuffer &commands, int16 oper1, int16 oper2);
 
-			uint64 op_Transfer(Register &resultRegister, Controller *controller, int16 oper1, int16 oper2);
+			// Deferred command application, run from the controller's post_update. Attacks and transfers are applied
+			// per target cell during the parallel group phase, where splits also build their offspring's genome;
+			// splits then only allocate and hand off the child serially in CellID order.
+			static void prepare_split(SplitCmd &command, CommandBuffer &local);
+			static void commit_split(const SplitCmd &command, GenomeRef &genome);
+			static void commit_attack(const AttackCmd &command);
+			static void commit_transfer(const TransferCmd &command, const CommandBuffer &buffer);
 
 			enum class OperandType
 			{
@@ -0,0 +1,550 @@
+#include "phylogen.hpp"
+#include "Simulation/Simulation.hpp"
+
+#if defined(_WIN32)
+#	include <Windows.h>
+#else
+#	include <sys/mman.h>
+#endif
+
+using namespace phylo;
+using namespace phylo::VM;
+
+namespace
+{
+	static atomic<uint64> s_Genomes = { 0 };
+	static atomic<uint64> s_CodeBytes = { 0 };
+	static atomic<uint64> s_Mismatches = { 0 };
+
+	static constexpr uint NumRegisters = Instance::NumRegisters;
+	static_assert(sizeof(Instance::Register) == sizeof(uint16), "Blocks address the register file as plain words");
+	static_assert((NumRegisters & (NumRegisters - 1)) == 0, "Register indices are reduced with a mask");
+	static_assert(NumRegisters * sizeof(uint16) <= 127, "Register displacements must fit a signed byte");
+
+	// Argument registers of the platform calling convention.
+#if defined(_WIN32)
+	static constexpr uint8 Arg0 = 1; // rcx
+	static constexpr uint8 Arg1 = 2; // rdx
+#else
+	static constexpr uint8 Arg0 = 7; // rdi
+	static constexpr uint8 Arg1 = 6; // rsi
+#endif
+
+	static constexpr uint8 EAX = 0;
+	static constexpr uint8 EDX = 2;
+	static constexpr uint8 R10D = 10;
+
+	// A decoded operand: either the index of a VM register or an immediate.
+	struct Operand final
+	{
+		bool   IsRegister;
+		uint16 Value;
+
+		uint8 displacement() const
+		{
+			return uint8(Value * sizeof(uint16));
+		}
+	};
+
+	// Just enough of an x86-64 assembler for the blocks below. Inside a block r8 holds the VM register file and r9 the
+	// program counter; rax, rdx and r10 are scratch. All of these are volatile in both the Windows and System V
+	// conventions, so blocks need no prologue and never touch the stack.
+	class Emitter final
+	{
+		array<uint8> m_Bytes;
+
+		// movzx/movsx reg32, word [r8 + disp8]
+		void load16(uint8 opcode, uint8 reg, uint8 disp)
+		{
+			emit(uint8(0x41 | ((reg & 8) ? 0x04 : 0x00)), 0x0F, opcode, uint8(0x40 | ((reg & 7) << 3)), disp);
+		}
+
+	public:
+		usize size() const
+		{
+			return m_Bytes.size();
+		}
+		const uint8 *data() const
+		{
+			return m_Bytes.data();
+		}
+
+		template <typename... Args>
+		void emit(Args... bytes)
+		{
+			(m_Bytes.push_back(uint8(bytes)), ...);
+		}
+		void imm32(uint32 value)
+		{
+			for (uint i = 0; i < 4; ++i)
+			{
+				emit(uint8(value >> (i * 8)));
+			}
+		}
+		void imm64(uint64 value)
+		{
+			imm32(uint32(value));
+			imm32(uint32(value >> 32));
+		}
+
+		void align()
+		{
+			while ((m_Bytes.size() & 15) != 0)
+			{
+				emit(0xCC);
+			}
+		}
+
+		// Forward short jumps. Returns the offset to patch once the target is known.
+		usize jump(uint8 opcode)
+		{
+			emit(opcode, 0x00);
+			return m_Bytes.size() - 1;
+		}
+		void bind(usize patch)
+		{
+			const usize distance = m_Bytes.size() - (patch + 1);
+			xassert(distance <= 127, "Short jump out of range");
+			m_Bytes[patch] = uint8(distance);
+		}
+
+		void load_registers()
+		{
+			// mov r8, [arg0 + Registers]
+			emit(0x4C, 0x8B, uint8(0x40 | Arg0), uint8(offsetof(JitCode::Frame, Registers)));
+		}
+		void load_program_counter()
+		{
+			// mov r9, [arg0 + ProgramCounter]
+			emit(0x4C, 0x8B, uint8(0x48 | Arg0), uint8(offsetof(JitCode::Frame, ProgramCounter)));
+		}
+
+		void mov_imm(uint8 reg, uint32 value)
+		{
+			if (reg & 8)
+			{
+				emit(0x41);
+			}
+			emit(uint8(0xB8 + (reg & 7)));
+			imm32(value);
+		}
+		// Zero- or sign-extends an operand into a 32-bit register.
+		void load_zx(uint8 reg, const Operand &operand)
+		{
+			if (operand.IsRegister)
+			{
+				load16(0xB7, reg, operand.displacement());
+			}
+			else
+			{
+				mov_imm(reg, operand.Value);
+			}
+		}
+		void load_sx(uint8 reg, const Operand &operand)
+		{
+			if (operand.IsRegister)
+			{
+				load16(0xBF, reg, operand.displacement());
+			}
+			else
+			{
+				mov_imm(reg, uint32(int32(int16(operand.Value))));
+			}
+		}
+
+		// mov word [r8 + disp8], ax / dx
+		void store(uint8 reg, uint16 index)
+		{
+			emit(0x66, 0x41, 0x89, uint8(0x40 | (reg << 3)), uint8(index * sizeof(uint16)));
+		}
+		// mov word [r8 + disp8], imm16
+		void store_imm(uint16 index, uint16 value)
+		{
+			emit(0x66, 0x41, 0xC7, 0x40, uint8(index * sizeof(uint16)), uint8(value), uint8(value >> 8));
+		}
+		// and reg, NumRegisters - 1
+		void mask_index(uint8 reg)
+		{
+			emit(0x83, uint8(0xE0 | reg), uint8(NumRegisters - 1));
+		}
+		// movzx eax, word [r8 + rax * 2]
+		void load_indexed_eax()
+		{
+			emit(0x41, 0x0F, 0xB7, 0x04, 0x40);
+		}
+		// mov word [r8 + rdx * 2], ax
+		void store_indexed_rdx()
+		{
+			emit(0x66, 0x41, 0x89, 0x04, 0x50);
+		}
+		// Converts the flags of 'test' on both operands to booleans in al and dl.
+		void booleans()
+		{
+			emit(0x85, 0xC0);       // test eax, eax
+			emit(0x0F, 0x95, 0xC0); // setnz al
+			emit(0x85, 0xD2);       // test edx, edx
+			emit(0x0F, 0x95, 0xC2); // setnz dl
+		}
+
+		void return_zero()
+		{
+			emit(0x31, 0xC0); // xor eax, eax
+			emit(0xC3);       // ret
+		}
+	};
+
+	// Emits the inline block for one decoded instruction. Returns false for instructions that go through the fallback.
+	static bool emit_inline(Emitter &out, VM::Operation opcode, uint16 result, const Operand &oper1, const Operand &oper2, uint slot, uint size)
+	{
+		switch (opcode)
+		{
+		case VM::Operation::NOP:
+			out.return_zero();
+			return true;
+
+		case VM::Operation::Copy:
+			out.load_registers();
+			if (oper1.IsRegister)
+			{
+				out.load_zx(EAX, oper1);
+				out.store(EAX, result);
+			}
+			else
+			{
+				out.store_imm(result, oper1.Value);
+			}
+			out.return_zero();
+			return true;
+
+		case VM::Operation::Load:
+			out.load_registers();
+			if (oper1.IsRegister)
+			{
+				out.load_zx(EAX, oper1);
+				out.mask_index(EAX);
+				out.load_indexed_eax();
+			}
+			else
+			{
+				out.load_zx(EAX, { true, uint16(oper1.Value % NumRegisters) });
+			}
+			out.store(EAX, result);
+			out.return_zero();
+			return true;
+
+		case VM::Operation::Store:
+		case VM::Operation::Load_Store:
+			out.load_registers();
+			out.load_zx(EDX, { true, result });
+			out.mask_index(EDX);
+			if (opcode == VM::Operation::Store)
+			{
+				out.load_zx(EAX, oper1);
+			}
+			else if (oper1.IsRegister)
+			{
+				out.load_zx(EAX, oper1);
+				out.mask_index(EAX);
+				out.load_indexed_eax();
+			}
+			else
+			{
+				out.load_zx(EAX, { true, uint16(oper1.Value % NumRegisters) });
+			}
+			out.store_indexed_rdx();
+			out.return_zero();
+			return true;
+
+		case VM::Operation::Add_Integer:
+		case VM::Operation::Subtract_Integer:
+		case VM::Operation::Multiply_Integer:
+			out.load_registers();
+			out.load_zx(EAX, oper1);
+			out.load_zx(EDX, oper2);
+			switch (opcode)
+			{
+			case VM::Operation::Add_Integer:
+				out.emit(0x01, 0xD0);       // add eax, edx
+				break;
+			case VM::Operation::Subtract_Integer:
+				out.emit(0x29, 0xD0);       // sub eax, edx
+				break;
+			default:
+				out.emit(0x0F, 0xAF, 0xC2); // imul eax, edx
+				break;
+			}
+			out.store(EAX, result);
+			out.return_zero();
+			return true;
+
+		case VM::Operation::Divide_Integer:
+		case VM::Operation::Modulo_Integer:
+		{
+			// Operands are promoted to int as in C++, so -32768 / -1 does not trap.
+			out.load_registers();
+			out.load_sx(EAX, oper1);
+			out.load_sx(R10D, oper2);
+			out.emit(0x45, 0x85, 0xD2);       // test r10d, r10d
+			const usize zero = out.jump(0x74); // jz
+			out.emit(0x99);                   // cdq
+			out.emit(0x41, 0xF7, 0xFA);       // idiv r10d
+			out.store((opcode == VM::Operation::Divide_Integer) ? EAX : EDX, result);
+			out.return_zero();
+			out.bind(zero);
+			out.store_imm(result, 0);
+			out.return_zero();
+			return true;
+		}
+
+		case VM::Operation::LogicalAND:
+		case VM::Operation::LogicalNAND:
+		case VM::Operation::LogicalOR:
+		case VM::Operation::LogicalNOR:
+		case VM::Operation::LogicalXOR:
+			out.load_registers();
+			out.load_zx(EAX, oper1);
+			out.load_zx(EDX, oper2);
+			out.booleans();
+			switch (opcode)
+			{
+			case VM::Operation::LogicalAND:
+			case VM::Operation::LogicalNAND:
+				out.emit(0x20, 0xD0); // and al, dl
+				break;
+			case VM::Operation::LogicalOR:
+			case VM::Operation::LogicalNOR:
+				out.emit(0x08, 0xD0); // or al, dl
+				break;
+			default:
+				out.emit(0x30, 0xD0); // xor al, dl
+				break;
+			}
+			if ((opcode == VM::Operation::LogicalNAND) | (opcode == VM::Operation::LogicalNOR))
+			{
+				out.emit(0x34, 0x01); // xor al, 1
+			}
+			out.emit(0x0F, 0xB6, 0xC0); // movzx eax, al
+			out.store(EAX, result);
+			out.return_zero();
+			return true;
+
+		case VM::Operation::LogicalNEGATE:
+			out.load_registers();
+			out.load_zx(EAX, oper1);
+			out.emit(0x85, 0xC0);       // test eax, eax
+			out.emit(0x0F, 0x94, 0xC0); // sete al
+			out.emit(0x0F, 0xB6, 0xC0); // movzx eax, al
+			out.store(EAX, result);
+			out.return_zero();
+			return true;
+
+		case VM::Operation::Jump:
+		case VM::Operation::Jump_Z:
+		case VM::Operation::Jump_NZ:
+		case VM::Operation::Jump_GZ:
+		case VM::Operation::Jump_LZ:
+		case VM::Operation::Jump_GEZ:
+		case VM::Operation::Jump_LEZ:
+		{
+			// The interpreter has already advanced the program counter to the next slot before executing.
+			const uint next = (slot + 1) % size;
+			const bool conditional = (opcode != VM::Operation::Jump);
+
+			// The short jump taken when the branch is *not* taken. Jump_LEZ matches op_JumpLEZ, which only
+			// rejects negative values.
+			uint8 skip = 0;
+			bool taken = true;
+			const int16 value = int16(oper2.Value);
+			switch (opcode)
+			{
+			case VM::Operation::Jump_Z:   skip = 0x75; taken = (value == 0); break; // jnz
+			case VM::Operation::Jump_NZ:  skip = 0x74; taken = (value != 0); break; // jz
+			case VM::Operation::Jump_GZ:  skip = 0x7E; taken = (value > 0);  break; // jle
+			case VM::Operation::Jump_LZ:  skip = 0x7D; taken = (value < 0);  break; // jge
+			case VM::Operation::Jump_GEZ:
+			case VM::Operation::Jump_LEZ: skip = 0x7C; taken = (value >= 0); break; // jl
+			default: break;
+			}
+
+			out.load_registers();
+			if (conditional && !oper2.IsRegister && !taken)
+			{
+				out.store_imm(result, 0);
+				out.return_zero();
+				return true;
+			}
+
+			// Both operands are read before the result register is written, as they may alias it.
+			if (oper1.IsRegister)
+			{
+				out.load_sx(EAX, oper1);
+			}
+			usize notTaken = 0;
+			const bool test = conditional && oper2.IsRegister;
+			if (test)
+			{
+				out.load_sx(EDX, oper2);
+				out.emit(0x85, 0xD2); // test edx, edx
+				notTaken = out.jump(skip);
+			}
+
+			out.load_program_counter();
+			if (oper1.IsRegister)
+			{
+				out.emit(0x05);       // add eax, next
+				out.imm32(next);
+				out.emit(0x31, 0xD2); // xor edx, edx
+				out.mov_imm(R10D, size);
+				out.emit(0x41, 0xF7, 0xF2); // div r10d
+				out.emit(0x41, 0x89, 0x11); // mov [r9], edx
+			}
+			else
+			{
+				uint target = next;
+				target += uint(int32(int16(oper1.Value)));
+				target %= size;
+				out.emit(0x41, 0xC7, 0x01); // mov dword [r9], target
+				out.imm32(target);
+			}
+			out.store_imm(result, 1);
+			out.return_zero();
+
+			if (test)
+			{
+				out.bind(notTaken);
+				out.store_imm(result, 0);
+				out.return_zero();
+			}
+			return true;
+		}
+
+		default:
+			return false;
+		}
+	}
+
+	static uint8 *allocate_executable(usize size)
+	{
+#if defined(_WIN32)
+		return (uint8 *)VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+		void *pages = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		return (pages == MAP_FAILED) ? nullptr : (uint8 *)pages;
+#endif
+	}
+
+	// Pages are never writable and executable at once.
+	static bool seal_executable(uint8 *code, usize size)
+	{
+#if defined(_WIN32)
+		DWORD previous;
+		if (!VirtualProtect(code, size, PAGE_EXECUTE_READ, &previous))
+		{
+			return false;
+		}
+		FlushInstructionCache(GetCurrentProcess(), code, size);
+		return true;
+#else
+		return mprotect(code, size, PROT_READ | PROT_EXEC) == 0;
+#endif
+	}
+
+	static void free_executable(uint8 *code, usize size)
+	{
+#if defined(_WIN32)
+		(void)size;
+		VirtualFree(code, 0, MEM_RELEASE);
+#else
+		munmap(code, size);
+#endif
+	}
+}
+
+JitCode::~JitCode()
+{
+	if (m_Code)
+	{
+		free_executable(m_Code, m_CodeSize);
+		s_Genomes.fetch_sub(1);
+		s_CodeBytes.fetch_sub(m_CodeSize);
+	}
+}
+
+JitCode *JitCode::compile(const Genome &genome, const GenomeAnalysis &analysis)
+{
+	if constexpr (!Available)
+	{
+		return nullptr;
+	}
+
+	const uint size = uint(genome.size());
+	JitCode *code = new JitCode;
+	code->m_Offsets.resize(size);
+	code->m_Opcodes.resize(size);
+	code->m_Inline.resize(size);
+
+	Emitter out;
+	uint slot = 0;
+	genome.for_each_span([&](const uint64 *words, usize count)
+	{
+		for (usize i = 0; i < count; ++i, ++slot)
+		{
+			out.align();
+			code->m_Offsets[slot] = uint32(out.size());
+
+			const uint64 operation = words[i];
+			const Instance::DecodedOperation decoded = Instance::decode(operation);
+			const Operand oper1 = { decoded.Operand1IsRegister, decoded.Operand1 };
+			const Operand oper2 = { decoded.Operand2IsRegister, decoded.Operand2 };
+
+			code->m_Opcodes[slot] = uint16(decoded.Opcode);
+			if (analysis.is_reachable(slot) && emit_inline(out, decoded.Opcode, decoded.Result, oper1, oper2, slot, size))
+			{
+				code->m_Inline[slot] = 1;
+				continue;
+			}
+
+			// mov arg1, operation; mov rax, fallback; jmp rax
+			code->m_Inline[slot] = 0;
+			out.emit(0x48, uint8(0xB8 + Arg1));
+			out.imm64(operation);
+			out.emit(0x48, 0xB8);
+			out.imm64(uint64(&JitCode::fallback));
+			out.emit(0xFF, 0xE0);
+		}
+	});
+	xassert(slot == size, "Genome spans do not cover the genome");
+
+	code->m_CodeSize = out.size();
+	code->m_Code = allocate_executable(code->m_CodeSize);
+	if (code->m_Code == nullptr)
+	{
+		delete code;
+		return nullptr;
+	}
+	memcpy(code->m_Code, out.data(), out.size());
+	if (!seal_executable(code->m_Code, code->m_CodeSize))
+	{
+		delete code;
+		return nullptr;
+	}
+
+	s_Genomes.fetch_add(1);
+	s_CodeBytes.fetch_add(code->m_CodeSize);
+	return code;
+}
+
+uint64 JitCode::fallback(Frame *frame, uint64 operation)
+{
+	return frame->Self->execute(operation, frame->Control, *frame->Commands);
+}
+
+void JitCode::report_mismatch()
+{
+	s_Mismatches.fetch_add(1);
+}
+
+JitCode::Statistics JitCode::get_statistics()
+{
+	return { s_Genomes.load(), s_CodeBytes.load(), s_Mismatches.load() };
+}
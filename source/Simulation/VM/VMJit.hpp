@@ -0,0 +1,81 @@
+#pragma once
+
+namespace phylo::VM
+{
+	struct Instance;
+	struct CommandBuffer;
+	class Genome;
+	struct GenomeAnalysis;
+
+	// Native x86-64 translation of one genome. Every bytecode slot gets its own block, entered through a per-slot table,
+	// so execution resumes from whatever the program counter says exactly as the interpreter would. A block performs only
+	// the decode and execute of its single instruction and returns the instruction's Cost; Instance::tick keeps the sleep,
+	// energy and kill handling, so the one-instruction-per-tick contract is untouched. Register, arithmetic, logic and
+	// jump instructions are emitted inline; everything else tail-calls back into Instance::execute.
+	class JitCode final
+	{
+	public:
+	#if (defined(_M_X64) || defined(__x86_64__)) && !ENABLE_TRANSLATION_TABLE
+		static constexpr bool Available = true;
+	#else
+		static constexpr bool Available = false;
+	#endif
+		// Executions a cell counts locally before adding them to its genome's shared tally.
+		static constexpr uint32 SampleInterval = 64;
+
+		// Everything a block needs, passed as its only argument.
+		struct Frame final
+		{
+			Instance      *Self;
+			Controller    *Control;
+			CommandBuffer *Commands;
+			uint16        *Registers;
+			uint          *ProgramCounter; // Already advanced past the slot being run, as in the interpreter.
+		};
+		using Block = uint64 (*)(Frame *frame);
+
+		struct Statistics final
+		{
+			uint64 Genomes;    // Genomes with native code.
+			uint64 CodeBytes;
+			uint64 Mismatches; // Slots where the verify mode saw native code disagree with the interpreter.
+		};
+
+	private:
+		uint8         *m_Code = nullptr;
+		usize         m_CodeSize = 0;
+		array<uint32> m_Offsets;  // Block entry per slot.
+		array<uint16> m_Opcodes;  // Decoded opcode per slot, for the execution counters.
+		array<uint8>  m_Inline;   // Slots whose block has no effects beyond registers and the program counter.
+
+		JitCode() = default;
+
+	public:
+		JitCode(const JitCode &) = delete;
+		JitCode &operator = (const JitCode &) = delete;
+		~JitCode();
+
+		// Returns nullptr when native code is unavailable on this platform. Slots the analysis finds unreachable are
+		// not translated; they still run, through the interpreter.
+		static JitCode *compile(const Genome &genome, const GenomeAnalysis &analysis);
+
+		uint64 run(uint slot, Frame &frame) const
+		{
+			return Block(m_Code + m_Offsets[slot])(&frame);
+		}
+		uint16 opcode(uint slot) const
+		{
+			return m_Opcodes[slot];
+		}
+		bool is_inline(uint slot) const
+		{
+			return m_Inline[slot] != 0;
+		}
+
+		// The target of blocks that are not emitted inline.
+		static uint64 fallback(Frame *frame, uint64 operation);
+
+		static void report_mismatch();
+		static Statistics get_statistics();
+	};
+}
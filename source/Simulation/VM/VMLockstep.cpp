@@ -0,0 +1,190 @@
+#include "phylogen.hpp"
+#include "Simulation/Simulation.hpp"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#	include <emmintrin.h>
+#	define PHYLO_LOCKSTEP_SSE2 1
+#endif
+
+using namespace phylo;
+using namespace phylo::VM;
+
+namespace
+{
+	// Lanes are processed eight at a time; the arrays are padded so the last block may run past the group.
+	static constexpr uint VectorWidth = 8;
+
+#if PHYLO_LOCKSTEP_SSE2
+	// Computes 'count' results, rounded up to the vector width.
+	static void vector_kernel(VM::Operation opcode, const uint16 *a, const uint16 *b, uint16 *result, uint count)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i one = _mm_set1_epi16(1);
+		for (uint i = 0; i < count; i += VectorWidth)
+		{
+			const __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+			const __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+			// All ones in lanes whose operand is zero.
+			const __m128i zeroA = _mm_cmpeq_epi16(va, zero);
+			const __m128i zeroB = _mm_cmpeq_epi16(vb, zero);
+
+			__m128i vr;
+			switch (opcode)
+			{
+			case VM::Operation::Copy:             vr = va; break;
+			case VM::Operation::Add_Integer:      vr = _mm_add_epi16(va, vb); break;
+			case VM::Operation::Subtract_Integer: vr = _mm_sub_epi16(va, vb); break;
+			case VM::Operation::Multiply_Integer: vr = _mm_mullo_epi16(va, vb); break;
+			case VM::Operation::LogicalAND:       vr = _mm_andnot_si128(_mm_or_si128(zeroA, zeroB), one); break;
+			case VM::Operation::LogicalNAND:      vr = _mm_and_si128(_mm_or_si128(zeroA, zeroB), one); break;
+			case VM::Operation::LogicalOR:        vr = _mm_andnot_si128(_mm_and_si128(zeroA, zeroB), one); break;
+			case VM::Operation::LogicalNOR:       vr = _mm_and_si128(_mm_and_si128(zeroA, zeroB), one); break;
+			case VM::Operation::LogicalNEGATE:    vr = _mm_and_si128(zeroA, one); break;
+			case VM::Operation::LogicalXOR:       vr = _mm_and_si128(_mm_xor_si128(zeroA, zeroB), one); break;
+			default:
+				xassert(false, "Not a lockstep vector operation");
+				return;
+			}
+			_mm_storeu_si128((__m128i *)(result + i), vr);
+		}
+	}
+#else
+	static uint16 scalar_kernel(VM::Operation opcode, uint16 a, uint16 b)
+	{
+		const bool boolA = (a != 0);
+		const bool boolB = (b != 0);
+		switch (opcode)
+		{
+		case VM::Operation::Copy:             return a;
+		case VM::Operation::Add_Integer:      return uint16(int16(a) + int16(b));
+		case VM::Operation::Subtract_Integer: return uint16(int16(a) - int16(b));
+		case VM::Operation::Multiply_Integer: return uint16(int16(a) * int16(b));
+		case VM::Operation::LogicalAND:       return (boolA && boolB) ? 1_u16 : 0_u16;
+		case VM::Operation::LogicalNAND:      return !(boolA && boolB) ? 1_u16 : 0_u16;
+		case VM::Operation::LogicalOR:        return (boolA || boolB) ? 1_u16 : 0_u16;
+		case VM::Operation::LogicalNOR:       return !(boolA || boolB) ? 1_u16 : 0_u16;
+		case VM::Operation::LogicalNEGATE:    return !boolA ? 1_u16 : 0_u16;
+		case VM::Operation::LogicalXOR:       return (boolA != boolB) ? 1_u16 : 0_u16;
+		default:
+			xassert(false, "Not a lockstep vector operation");
+			return 0;
+		}
+	}
+
+	static void vector_kernel(VM::Operation opcode, const uint16 *a, const uint16 *b, uint16 *result, uint count)
+	{
+		for (uint i = 0; i < count; ++i)
+		{
+			result[i] = scalar_kernel(opcode, a[i], b[i]);
+		}
+	}
+#endif
+}
+
+bool Lockstep::is_vector_op(VM::Operation opcode)
+{
+	switch (opcode)
+	{
+	case VM::Operation::Copy:
+	case VM::Operation::Add_Integer:
+	case VM::Operation::Subtract_Integer:
+	case VM::Operation::Multiply_Integer:
+	case VM::Operation::LogicalAND:
+	case VM::Operation::LogicalNAND:
+	case VM::Operation::LogicalOR:
+	case VM::Operation::LogicalNOR:
+	case VM::Operation::LogicalNEGATE:
+	case VM::Operation::LogicalXOR:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void Lockstep::run(Instance *instances, uint count, Controller *controller, Instance::CounterType &counter, CommandBuffer &commands)
+{
+	m_Lanes.clear();
+	for (uint i = 0; i < count; ++i)
+	{
+		Instance &instance = instances[i];
+		uint slot;
+		if (instance.begin_tick(counter, commands, slot))
+		{
+#if ENABLE_TRANSLATION_TABLE
+			// Every cell decodes through its own table, so cells sharing a genome do not share instructions.
+			instance.end_tick(instance.run_slot(slot, controller, counter, commands), commands);
+#else
+			m_Lanes.push_back({ &instance, instance.m_ByteCode.id(), slot });
+#endif
+		}
+	}
+
+	// Group lanes by genome, then by slot within it.
+	radix_sort(m_Lanes, m_Scratch, [](const Lane &lane) { return uint64(lane.Slot); });
+	radix_sort(m_Lanes, m_Scratch, [](const Lane &lane) { return lane.GenomeID; });
+
+	const Lane *lanes = m_Lanes.data();
+	const uint numLanes = uint(m_Lanes.size());
+	for (uint begin = 0; begin < numLanes;)
+	{
+		uint end = begin + 1;
+		while ((end < numLanes) && (lanes[end].GenomeID == lanes[begin].GenomeID) && (lanes[end].Slot == lanes[begin].Slot))
+		{
+			++end;
+		}
+		run_group(lanes + begin, end - begin, controller, counter, commands);
+		begin = end;
+	}
+}
+
+void Lockstep::run_group(const Lane *lanes, uint count, Controller *controller, Instance::CounterType &counter, CommandBuffer &commands)
+{
+	const uint64 operation = lanes[0].VM->m_ByteCode[lanes[0].Slot];
+	const Instance::DecodedOperation decoded = Instance::decode(operation);
+	counter[uint(decoded.Opcode)] += count;
+
+	if ((count >= MinVectorLanes) && is_vector_op(decoded.Opcode))
+	{
+		// These never cost energy, so there is nothing left for end_tick to charge.
+		run_vector(lanes, count, decoded);
+		return;
+	}
+
+	for (uint i = 0; i < count; ++i)
+	{
+		Instance &instance = *lanes[i].VM;
+		instance.end_tick(instance.execute(operation, controller, commands), commands);
+	}
+}
+
+void Lockstep::run_vector(const Lane *lanes, uint count, const Instance::DecodedOperation &decoded)
+{
+	const uint padded = (count + (VectorWidth - 1)) & ~(VectorWidth - 1);
+	m_Operand1.resize(padded);
+	m_Operand2.resize(padded);
+	m_Result.resize(padded);
+
+	// Gather. Immediates are broadcast.
+	uint16 * __restrict operand1 = m_Operand1.data();
+	uint16 * __restrict operand2 = m_Operand2.data();
+	for (uint i = 0; i < count; ++i)
+	{
+		const auto &registers = lanes[i].VM->m_Registers;
+		operand1[i] = decoded.Operand1IsRegister ? uint16(registers[decoded.Operand1]) : decoded.Operand1;
+		operand2[i] = decoded.Operand2IsRegister ? uint16(registers[decoded.Operand2]) : decoded.Operand2;
+	}
+	for (uint i = count; i < padded; ++i)
+	{
+		operand1[i] = 0;
+		operand2[i] = 0;
+	}
+
+	vector_kernel(decoded.Opcode, operand1, operand2, m_Result.data(), padded);
+
+	// Scatter.
+	const uint16 *result = m_Result.data();
+	for (uint i = 0; i < count; ++i)
+	{
+		lanes[i].VM->m_Registers[decoded.Result] = result[i];
+	}
+}
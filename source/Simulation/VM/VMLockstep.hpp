@@ -0,0 +1,37 @@
+#pragma once
+
+namespace phylo::VM
+{
+	// Executes a run of instances in lockstep: cells that share a genome and are at the same slot run that slot's
+	// instruction together. The word is decoded once per group, and pure register arithmetic and logic is applied
+	// across the whole group with SIMD over 16-bit lanes. Jumps, whose lanes diverge, and everything touching the
+	// cell or the controller fall back to executing each lane on its own. Per-cell results are identical to tick().
+	//
+	// A cell executes a single instruction per tick, so register files stay in their instances; a group gathers its
+	// operands into SoA lanes, computes, and scatters the results back.
+	class Lockstep final
+	{
+		// Groups smaller than this run each lane through the interpreter, which is cheaper than gathering.
+		static constexpr uint MinVectorLanes = 8;
+
+		struct Lane final
+		{
+			Instance *VM;
+			uint64   GenomeID;
+			uint32   Slot;
+		};
+
+		array<Lane>   m_Lanes;
+		array<Lane>   m_Scratch;
+		array<uint16> m_Operand1;
+		array<uint16> m_Operand2;
+		array<uint16> m_Result;
+
+		static bool is_vector_op(VM::Operation opcode);
+		void run_group(const Lane *lanes, uint count, Controller *controller, Instance::CounterType &counter, CommandBuffer &commands);
+		void run_vector(const Lane *lanes, uint count, const Instance::DecodedOperation &decoded);
+
+	public:
+		void run(Instance *instances, uint count, Controller *controller, Instance::CounterType &counter, CommandBuffer &commands);
+	};
+}
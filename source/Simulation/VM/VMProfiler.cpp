@@ -0,0 +1,154 @@
+#include "phylogen.hpp"
+#include "Simulation/Simulation.hpp"
+
+using namespace phylo;
+using namespace phylo::VM;
+
+void ProfileReport::reset()
+{
+	memset(m_Samples.data(), 0, m_Samples.size_raw());
+	memset(m_Cycles.data(), 0, m_Cycles.size_raw());
+	m_Heat.clear();
+	m_Ticks = 0;
+}
+
+void ProfileReport::fold(WorkerLocal<Profiler> &profilers)
+{
+	++m_Ticks;
+
+	m_Pending.clear();
+	for (Profiler &profiler : profilers)
+	{
+		for (usize opcode = 0; opcode < NumOperations; ++opcode)
+		{
+			m_Samples[opcode] += profiler.m_Samples[opcode];
+			m_Cycles[opcode] += profiler.m_Cycles[opcode];
+			profiler.m_Samples[opcode] = 0;
+			profiler.m_Cycles[opcode] = 0;
+		}
+		for (const Profiler::Sample &sample : profiler.m_Heat)
+		{
+			m_Pending.push_back(sample);
+		}
+		profiler.m_Heat.clear();
+	}
+	if (m_Pending.size() == 0)
+	{
+		return;
+	}
+
+	radix_sort(m_Pending, m_PendingScratch, [](const Profiler::Sample &sample) { return uint64(sample.Slot); });
+	radix_sort(m_Pending, m_PendingScratch, [](const Profiler::Sample &sample) { return sample.GenomeHash; });
+
+	// Merge the new samples into the sorted heat entries.
+	auto less = [](uint64 genomeA, uint32 slotA, uint64 genomeB, uint32 slotB)
+	{
+		return (genomeA < genomeB) | ((genomeA == genomeB) & (slotA < slotB));
+	};
+
+	m_Merged.clear();
+	usize heat = 0;
+	usize pending = 0;
+	while ((heat < m_Heat.size()) | (pending < m_Pending.size()))
+	{
+		if ((pending == m_Pending.size()) || ((heat < m_Heat.size()) && !less(m_Pending[pending].GenomeHash, m_Pending[pending].Slot, m_Heat[heat].GenomeHash, m_Heat[heat].Slot)))
+		{
+			const HeatEntry &entry = m_Heat[heat++];
+			if ((m_Merged.size() != 0) && (m_Merged.back().GenomeHash == entry.GenomeHash) && (m_Merged.back().Slot == entry.Slot))
+			{
+				m_Merged.back().Hits += entry.Hits;
+			}
+			else
+			{
+				m_Merged.push_back(entry);
+			}
+			continue;
+		}
+
+		const Profiler::Sample &sample = m_Pending[pending++];
+		if ((m_Merged.size() != 0) && (m_Merged.back().GenomeHash == sample.GenomeHash) && (m_Merged.back().Slot == sample.Slot))
+		{
+			++m_Merged.back().Hits;
+		}
+		else
+		{
+			m_Merged.push_back({ sample.GenomeHash, sample.Slot, sample.Opcode, 1 });
+		}
+	}
+	std::swap(m_Heat, m_Merged);
+}
+
+bool ProfileReport::write(const string &path) const
+{
+	uint64 totalSamples = 0;
+	uint64 totalCycles = 0;
+	for (usize opcode = 0; opcode < NumOperations; ++opcode)
+	{
+		totalSamples += m_Samples[opcode];
+		totalCycles += m_Cycles[opcode];
+	}
+
+	string report;
+	report += string::format("# VM profile: %llu ticks, %llu samples, 1 in %u instructions timed\n", m_Ticks, totalSamples, Profiler::SampleInterval);
+#if PHYLO_PROFILER_RDTSC
+	report += "# time unit: TSC cycles\n";
+#else
+	report += "# time unit: nanoseconds\n";
+#endif
+
+	report += "\n[opcodes] name, samples, mean time, share of sampled time\n";
+	for (usize opcode = 0; opcode < NumOperations; ++opcode)
+	{
+		const uint64 samples = m_Samples[opcode];
+		const double mean = (samples != 0) ? double(m_Cycles[opcode]) / double(samples) : 0.0;
+		const double share = (totalCycles != 0) ? 100.0 * double(m_Cycles[opcode]) / double(totalCycles) : 0.0;
+		report += string::format("%-32s %12llu %12.1f %7.3f%%\n", Instance::getInstructionName(uint16(opcode)), samples, mean, share);
+	}
+
+	// Genome totals, hottest first.
+	struct GenomeTotal final
+	{
+		uint64 GenomeHash;
+		usize  First; // Into m_Heat.
+		usize  End;
+		uint64 Hits;
+	};
+	array<GenomeTotal> genomes;
+	for (usize i = 0; i < m_Heat.size();)
+	{
+		GenomeTotal total = { m_Heat[i].GenomeHash, i, i, 0 };
+		for (; (total.End < m_Heat.size()) && (m_Heat[total.End].GenomeHash == total.GenomeHash); ++total.End)
+		{
+			total.Hits += m_Heat[total.End].Hits;
+		}
+		genomes.push_back(total);
+		i = total.End;
+	}
+	std::sort(genomes.data(), genomes.data() + genomes.size(), [](const GenomeTotal &a, const GenomeTotal &b)
+	{
+		return (a.Hits != b.Hits) ? (a.Hits > b.Hits) : (a.GenomeHash < b.GenomeHash);
+	});
+
+	report += string::format("\n[genomes] %llu sampled, hottest %u by slot: slot, opcode, samples\n", uint64(genomes.size()), ReportedGenomes);
+	for (usize i = 0; i < min(genomes.size(), usize(ReportedGenomes)); ++i)
+	{
+		const GenomeTotal &genome = genomes[i];
+		report += string::format("genome %016llx: %llu samples\n", genome.GenomeHash, genome.Hits);
+		for (usize entry = genome.First; entry < genome.End; ++entry)
+		{
+			const HeatEntry &heat = m_Heat[entry];
+			report += string::format("  %6u %-32s %12llu\n", heat.Slot, Instance::getInstructionName(heat.Opcode), heat.Hits);
+		}
+	}
+
+	try
+	{
+		io::file outFile(path, io::file::Flags::New | io::file::Flags::Sequential | io::file::Flags::Write, report.size());
+		outFile.write(0, report.data(), report.size());
+	}
+	catch (...)
+	{
+		return false;
+	}
+	return true;
+}
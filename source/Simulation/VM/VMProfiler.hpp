@@ -0,0 +1,120 @@
+#pragma once
+
+#if defined(_M_X64) || defined(__x86_64__)
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#	else
+#		include <x86intrin.h>
+#	endif
+#	define PHYLO_PROFILER_RDTSC 1
+#endif
+
+#include <chrono>
+
+#include "Scheduler.hpp"
+
+namespace phylo::VM
+{
+	// Sampling profiler for the VM phase, one per VM pool thread. Every SampleInterval-th instruction a thread executes
+	// is timed and attributed to its opcode and to its slot in its genome. Controller instructions are timed whole, so
+	// their samples include the findCell lookups they make. Ticks are only instrumented through Instance::tick<true>;
+	// the unprofiled instantiation contains none of this.
+	class Profiler final
+	{
+	public:
+		// Prime, so the sampling stride does not line up with loops in the genomes being sampled.
+		static constexpr uint SampleInterval = 61;
+
+		struct Sample final
+		{
+			uint64 GenomeHash; // Content hash, so that reports from different runs line up.
+			uint32 Slot;
+			uint16 Opcode;
+		};
+
+	private:
+		friend class ProfileReport;
+
+		array<uint64, NumOperations> m_Samples;
+		array<uint64, NumOperations> m_Cycles;
+		array<Sample>                m_Heat;
+		uint                         m_Countdown = SampleInterval;
+
+	public:
+		Profiler()
+		{
+			reset();
+		}
+
+		void reset()
+		{
+			memset(m_Samples.data(), 0, m_Samples.size_raw());
+			memset(m_Cycles.data(), 0, m_Cycles.size_raw());
+			m_Heat.clear();
+			m_Countdown = SampleInterval;
+		}
+
+		// Processor timestamp counter where there is one, otherwise the steady clock in nanoseconds.
+		static uint64 timestamp()
+		{
+#if PHYLO_PROFILER_RDTSC
+			return __rdtsc();
+#else
+			return uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+		}
+
+		// Called once per executed instruction; true when this one should be timed.
+		bool should_sample()
+		{
+			if (--m_Countdown != 0) [[likely]]
+			{
+				return false;
+			}
+			m_Countdown = SampleInterval;
+			return true;
+		}
+
+		void record(uint16 opcode, uint64 genomeHash, uint slot, uint64 cycles)
+		{
+			++m_Samples[opcode];
+			m_Cycles[opcode] += cycles;
+			m_Heat.push_back({ genomeHash, uint32(slot), opcode });
+		}
+	};
+
+	// Accumulates every thread's samples over a profiling session and writes them out as text. The report lists
+	// opcodes in enum order and genomes hottest first, so reports from two builds diff line by line.
+	class ProfileReport final
+	{
+		static constexpr uint ReportedGenomes = 32;
+
+		struct HeatEntry final
+		{
+			uint64 GenomeHash;
+			uint32 Slot;
+			uint16 Opcode;
+			uint64 Hits;
+		};
+
+		array<uint64, NumOperations> m_Samples;
+		array<uint64, NumOperations> m_Cycles;
+		array<HeatEntry>             m_Heat;        // Sorted by genome, then slot.
+		array<HeatEntry>             m_Merged;
+		array<Profiler::Sample>      m_Pending;
+		array<Profiler::Sample>      m_PendingScratch;
+		uint64                       m_Ticks = 0;
+
+	public:
+		ProfileReport()
+		{
+			reset();
+		}
+
+		void reset();
+		// Moves the threads' samples into the report, emptying their buffers. Called once per tick.
+		void fold(WorkerLocal<Profiler> &profilers);
+		// Returns false if the file could not be written.
+		bool write(const string &path) const;
+	};
+}
@@ -0,0 +1,258 @@
+#include "phylogen.hpp"
+#include "Topology.hpp"
+
+#include <tuple>
+#include <Windows.h>
+
+using namespace phylo;
+
+namespace
+{
+   static constexpr uint NotRanked = traits<uint>::max;
+
+   static bool in_mask(const Topology::Processor &processor, const GROUP_AFFINITY &mask)
+   {
+      return (processor.Group == mask.Group) & ((mask.Mask & (KAFFINITY(1) << processor.Number)) != 0);
+   }
+}
+
+const Topology &Topology::get()
+{
+   static Topology topology;
+   return topology;
+}
+
+Topology::Topology()
+{
+   DWORD length = 0;
+   GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+   array<uint8> buffer;
+   buffer.resize(length);
+   if (!GetLogicalProcessorInformationEx(RelationAll, PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX(buffer.data()), &length)) [[unlikely]]
+   {
+      // Nothing to go on, so every processor is taken to be a core of its own.
+      const uint count = max(uint(system::get_system_information().logical_core_count), 1u);
+      m_Processors.resize(count);
+      for (uint i = 0; i < count; ++i)
+      {
+         m_Processors[i] = { uint16(i / 64), uint8(i % 64), 0, 0, i, 0 };
+      }
+      return;
+   }
+
+   const auto for_each_record = [&](LOGICAL_PROCESSOR_RELATIONSHIP relationship, const auto &fn) {
+      for (DWORD offset = 0; offset < length;)
+      {
+         const auto &record = *PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX(buffer.data() + offset);
+         if (record.Relationship == relationship)
+         {
+            fn(record);
+         }
+         offset += record.Size;
+      }
+   };
+
+   // Cores first, as they list each of their processors.
+   uint32 core = 0;
+   for_each_record(RelationProcessorCore, [&](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX &record) {
+      uint32 thread = 0;
+      for (WORD group = 0; group < record.Processor.GroupCount; ++group)
+      {
+         const GROUP_AFFINITY &mask = record.Processor.GroupMask[group];
+         for (uint8 number = 0; number < 64; ++number)
+         {
+            if (mask.Mask & (KAFFINITY(1) << number))
+            {
+               m_Processors.push_back({ mask.Group, number, 0, 0, core, thread++ });
+            }
+         }
+      }
+      ++core;
+   });
+
+   for_each_record(RelationNumaNode, [&](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX &record) {
+      for (Processor &processor : m_Processors)
+      {
+         if (in_mask(processor, record.NumaNode.GroupMask))
+         {
+            processor.Node = record.NumaNode.NodeNumber;
+         }
+      }
+   });
+
+   const auto is_shared_cache = [](const CACHE_RELATIONSHIP &cache) {
+      return (cache.Type == CacheUnified) | (cache.Type == CacheData);
+   };
+   BYTE lastLevel = 0;
+   for_each_record(RelationCache, [&](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX &record) {
+      if (is_shared_cache(record.Cache))
+      {
+         lastLevel = max(lastLevel, record.Cache.Level);
+      }
+   });
+   uint32 cache = 0;
+   for_each_record(RelationCache, [&](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX &record) {
+      if (!is_shared_cache(record.Cache) | (record.Cache.Level != lastLevel))
+      {
+         return;
+      }
+      for (Processor &processor : m_Processors)
+      {
+         if (in_mask(processor, record.Cache.GroupMask))
+         {
+            processor.Cache = cache;
+         }
+      }
+      ++cache;
+   });
+
+   std::sort(m_Processors.data(), m_Processors.data() + m_Processors.size(), [](const Processor &a, const Processor &b) {
+      return std::tie(a.Group, a.Number) < std::tie(b.Group, b.Number);
+   });
+}
+
+array<uint> Topology::order(Pinning pinning, bool smt, const array<uint> &list) const
+{
+   array<uint> result;
+   if (pinning == Pinning::List)
+   {
+      for (uint processor : list)
+      {
+         if (processor < m_Processors.size())
+         {
+            result.push_back(processor);
+         }
+         else
+         {
+            xdebug("PHYLO", "Processor %u does not exist; leaving it out", processor);
+         }
+      }
+      return result;
+   }
+
+   for (uint i = 0; i < m_Processors.size(); ++i)
+   {
+      if (smt | (m_Processors[i].Thread == 0))
+      {
+         result.push_back(i);
+      }
+   }
+   if (pinning == Pinning::None)
+   {
+      return result;
+   }
+
+   const auto compact_order = [this](uint a, uint b) {
+      const Processor &pa = m_Processors[a];
+      const Processor &pb = m_Processors[b];
+      return std::tie(pa.Node, pa.Cache, pa.Core, pa.Thread, a) < std::tie(pb.Node, pb.Cache, pb.Core, pb.Thread, b);
+   };
+   std::sort(result.data(), result.data() + result.size(), compact_order);
+   if (pinning == Pinning::Compact)
+   {
+      return result;
+   }
+
+   // Rank each core among its cache's cores and each cache among its node's, going through them in compact order;
+   // scattering is then the compact order with those ranks ahead of the node.
+   uint32 maxCore = 0, maxCache = 0, maxNode = 0;
+   for (const Processor &processor : m_Processors)
+   {
+      maxCore = max(maxCore, processor.Core);
+      maxCache = max(maxCache, processor.Cache);
+      maxNode = max(maxNode, processor.Node);
+   }
+   array<uint> coreRanks;
+   array<uint> cacheRanks;
+   array<uint> coresInCache;
+   array<uint> cachesInNode;
+   coreRanks.resize(maxCore + 1, NotRanked);
+   cacheRanks.resize(maxCache + 1, NotRanked);
+   coresInCache.resize(maxCache + 1, 0);
+   cachesInNode.resize(maxNode + 1, 0);
+   for (uint i : result)
+   {
+      const Processor &processor = m_Processors[i];
+      if (cacheRanks[processor.Cache] == NotRanked)
+      {
+         cacheRanks[processor.Cache] = cachesInNode[processor.Node]++;
+      }
+      if (coreRanks[processor.Core] == NotRanked)
+      {
+         coreRanks[processor.Core] = coresInCache[processor.Cache]++;
+      }
+   }
+
+   std::sort(result.data(), result.data() + result.size(), [&](uint a, uint b) {
+      const Processor &pa = m_Processors[a];
+      const Processor &pb = m_Processors[b];
+      return
+         std::tie(pa.Thread, coreRanks[pa.Core], cacheRanks[pa.Cache], pa.Node, a) <
+         std::tie(pb.Thread, coreRanks[pb.Core], cacheRanks[pb.Cache], pb.Node, b);
+   });
+   return result;
+}
+
+void Topology::pin_current_thread(uint processor) const
+{
+   const Processor &target = m_Processors[processor];
+   GROUP_AFFINITY affinity;
+   memzero(affinity);
+   affinity.Group = target.Group;
+   affinity.Mask = KAFFINITY(1) << target.Number;
+   SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr);
+}
+
+bool Topology::parse_list(const string_view &text, array<uint> &list)
+{
+   usize i = 0;
+   const auto parse_number = [&](uint &value) {
+      if ((i == text.size()) || (text[i] < '0') || (text[i] > '9'))
+      {
+         return false;
+      }
+      value = 0;
+      while ((i < text.size()) && (text[i] >= '0') && (text[i] <= '9'))
+      {
+         value = (value * 10) + uint(text[i] - '0');
+         if (value >= MaxProcessors)
+         {
+            return false;
+         }
+         ++i;
+      }
+      return true;
+   };
+
+   for (;;)
+   {
+      uint first, last;
+      if (!parse_number(first))
+      {
+         return false;
+      }
+      last = first;
+      if ((i < text.size()) && (text[i] == '-'))
+      {
+         ++i;
+         if (!parse_number(last) || (last < first))
+         {
+            return false;
+         }
+      }
+      for (uint processor = first; processor <= last; ++processor)
+      {
+         list.push_back(processor);
+      }
+
+      if (i == text.size())
+      {
+         return true;
+      }
+      if (text[i] != ',')
+      {
+         return false;
+      }
+      ++i;
+   }
+}
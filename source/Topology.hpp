@@ -0,0 +1,59 @@
+#pragma once
+
+#include <xtd/xtd>
+
+namespace phylo
+{
+   // The machine's logical processors and where each of them sits: its NUMA node, the last-level cache it shares
+   // (one per CCX on Zen), its physical core, and which of that core's SMT threads it is. Read from the OS once.
+   //
+   // Processors are numbered in OS order, by processor group and then by number within the group, which is the
+   // numbering Task Manager and explicit processor lists use. Groups are what lets this go past 64 processors.
+   class Topology final
+   {
+   public:
+      // More than Windows can address; processor numbers and worker counts past it are rejected.
+      static constexpr uint MaxProcessors = 4096;
+
+      struct Processor final
+      {
+         uint16 Group;
+         uint8  Number;  // Within the group.
+         uint32 Node;
+         uint32 Cache;   // Machine-wide index of the last-level cache.
+         uint32 Core;    // Machine-wide index of the physical core.
+         uint32 Thread;  // 0 for a core's first SMT thread, 1 for its second, and so on.
+      };
+
+      enum class Pinning : uint
+      {
+         None,     // Leave placement to the OS.
+         Compact,  // Fill a core's threads, a cache's cores and a node's caches before moving on to the next.
+         Scatter,  // Spread over nodes, then caches, then cores, before putting a second thread on any core.
+         List,     // Exactly the processors given, in the order given.
+      };
+
+   private:
+      array<Processor> m_Processors;
+
+      Topology();
+
+   public:
+      static const Topology &get();
+
+      const array<Processor> &processors() const
+      {
+         return m_Processors;
+      }
+
+      // The processors to put workers on, first to last. Without SMT, only each core's first thread is used; an
+      // explicit list is taken as it is. With Pinning::None, these are only counted.
+      array<uint> order(Pinning pinning, bool smt, const array<uint> &list) const;
+
+      void pin_current_thread(uint processor) const;
+
+      // Parses a processor list such as "0-15,32-47". Returns false if it is malformed or names a processor past
+      // MaxProcessors.
+      static bool parse_list(const string_view &text, array<uint> &list);
+   };
+}
@@ -16,45 +16,6 @@ static void memzero(T &val)
 
 #include "SimOptions.hpp"
 
-namespace phylo
-{
-   struct Task// final : xtd::trait_simple
-   {
-      uint64            CellID;
-      function<void()>  Function;
-
-	  Task(uint64 cell_id, function<void()>&& functor) :
-		  CellID(cell_id),
-         Function(std::move(functor))
-      {}
-
-	  Task(const Task &) = default;
-	  Task(Task &&) = default;
-
-	  Task & operator = (const Task &) = default;
-	  Task & operator = (Task &&) = default;
-
-      auto operator <=> (const Task &task) const 
-      {
-         return CellID <=> task.CellID;
-      }
-
-      operator uint64 () const 
-      {
-         return CellID;
-      }
-   };
-}
-
-//namespace std
-//{
-//	template<>
-//	void swap(phylo::Task& lhs, phylo::Task& rhs)
-//	{
-//		// ... blah
-//	}
-//}
-
 class Stream
 {
    static constexpr const usize cuSizeExpandAlign = 0x1000ULL;